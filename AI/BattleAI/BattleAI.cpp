@@ -6,6 +6,9 @@
 #include "../../lib/CCreatureHandler.h"
 #include "../../lib/spells/CSpellHandler.h"
 #include "../../lib/VCMI_Lib.h"
+#include "../../lib/CThreadHelper.h"
+#include "../../lib/CConfigHandler.h"
+#include "BattleSearch.h"
 
 using boost::optional;
 static shared_ptr<CBattleCallback> cbc;
@@ -30,7 +33,7 @@ struct Priorities
 	}
 };
 
-Priorities *priorities = nullptr;
+Priorities *priorities = nullptr; //created in init, damageDiff reads it from worker threads of attemptCastingSpell
 
 
 namespace {
@@ -96,6 +99,8 @@ void CBattleAI::init(shared_ptr<CBattleCallback> CB)
 	print("init called, saving ptr to IBattleCallback");
 	cbc = cb = CB;
 	playerID = *CB->getPlayerID();; //TODO should be sth in callback
+	if(!priorities)
+		priorities = new Priorities;
 
 	wasWaitingForRealize = cb->waitTillRealize;
 	wasUnlockingGs = CB->unlockGsWhenWaiting;
@@ -153,7 +158,9 @@ BattleAction CBattleAI::activeStack( const CStack * stack )
 
 		if(targets.possibleAttacks.size())
 		{
-			auto hlp = targets.bestAction();
+			const int searchTime = settings["server"]["battleAISearchTime"].Float();
+			const int searchDepth = settings["server"]["battleAISearchDepth"].Float();
+			auto hlp = (searchTime > 0 || searchDepth > 0) ? lookAhead(stack, targets, searchTime, searchDepth) : targets.bestAction();
 			if(hlp.attack.shooting)
 				return BattleAction::makeShotAttack(stack, hlp.enemy);
 			else
@@ -440,13 +447,49 @@ void CBattleAI::attemptCastingSpell()
 	if(possibleCasts.empty())
 		return;
 
-	std::map<const CStack*, int> valueOfStack;
-	for(auto stack : cb->battleGetStacks())
+	//battle doesn't change while we are deciding, so all evaluations below are independent and run in parallel
+	const ui32 threads = std::max((ui32)1, boost::thread::hardware_concurrency());
+	boost::mutex errorMx;
+	std::exception_ptr error; //first failure, rethrown on calling thread
+
+	auto guarded = [&](std::function<void()> task) -> Task
 	{
-		PotentialTargets pt(stack);
-		valueOfStack[stack] = pt.bestActionValue();
+		return [=, &errorMx, &error]
+		{
+			try
+			{
+				task();
+			}
+			catch(...)
+			{
+				boost::unique_lock<boost::mutex> lock(errorMx);
+				if(!error)
+					error = std::current_exception();
+			}
+		};
+	};
+
+	const auto stacks = cb->battleGetStacks();
+	std::vector<int> stackValues(stacks.size());
+	std::vector<Task> tasks;
+	for(size_t i = 0; i < stacks.size(); i++)
+	{
+		tasks.push_back(guarded([&, i]
+		{
+			PotentialTargets pt(stacks[i]);
+			stackValues[i] = pt.bestActionValue();
+		}));
 	}
 
+	CThreadHelper stacksEvaluation(&tasks, threads);
+	stacksEvaluation.run();
+	if(error)
+		std::rethrow_exception(error);
+
+	std::map<const CStack*, int> valueOfStack;
+	for(size_t i = 0; i < stacks.size(); i++)
+		valueOfStack[stacks[i]] = stackValues[i];
+
 	auto evaluateSpellcast = [&] (const PossibleSpellcast &ps) -> int
 	{
 		const int skillLevel = hero->getSpellSchoolLevel(ps.spell);
@@ -498,7 +541,7 @@ void CBattleAI::attemptCastingSpell()
 
 				PotentialTargets pt(swb.stack, state);
 				auto newValue = pt.bestActionValue();
-				auto oldValue = valueOfStack[swb.stack];
+				auto oldValue = getValOr(valueOfStack, swb.stack, 0);
 				auto gain = newValue - oldValue;
 				if(swb.stack->owner != playerID) //enemy
 					gain = -gain;
@@ -514,7 +557,23 @@ void CBattleAI::attemptCastingSpell()
 		}
 	};
 
-	auto castToPerform = *vstd::maxElementByFun(possibleCasts, evaluateSpellcast);
+	std::vector<int> castValues(possibleCasts.size());
+	tasks.clear();
+	for(size_t i = 0; i < possibleCasts.size(); i++)
+	{
+		tasks.push_back(guarded([&, i]
+		{
+			castValues[i] = evaluateSpellcast(possibleCasts[i]);
+		}));
+	}
+
+	CThreadHelper castsEvaluation(&tasks, threads);
+	castsEvaluation.run();
+	if(error)
+		std::rethrow_exception(error);
+
+	//first of equally good casts is taken, so the choice doesn't depend on order in which evaluations finished
+	auto castToPerform = possibleCasts[boost::max_element(castValues) - castValues.begin()];
 	LOGFL("Best spell is %s. Will cast.", castToPerform.spell->name);
 
 	BattleAction spellcast;
@@ -608,10 +667,10 @@ ThreatMap::ThreatMap(const CStack *Endangered) : endangered(Endangered)
 	}
 }
 
-const TBonusListPtr StackWithBonuses::getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root /*= nullptr*/, const std::string &cachingStr /*= ""*/) const
+const TBonusListPtr StackWithBonuses::getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root /*= nullptr*/, const BonusCacheKey &cachingKey /*= BonusCacheKey()*/) const
 {
 	TBonusListPtr ret = make_shared<BonusList>();
-	const TBonusListPtr originalList = stack->getAllBonuses(selector, limit, root, cachingStr);
+	const TBonusListPtr originalList = stack->getAllBonuses(selector, limit, root, cachingKey);
 	range::copy(*originalList, std::back_inserter(*ret));
 	for(auto &bonus : bonusesToAdd)
 	{
@@ -626,8 +685,6 @@ const TBonusListPtr StackWithBonuses::getAllBonuses(const CSelector &selector, c
 
 int AttackPossibility::damageDiff() const
 {
-	if (!priorities)
-		priorities = new Priorities;
 	const auto dealtDmgValue = priorities->stackEvaluator(enemy) * damageDealt;
 	const auto receivedDmgValue = priorities->stackEvaluator(attack.attacker) * damageReceived;
 	return dealtDmgValue - receivedDmgValue;
@@ -719,6 +776,42 @@ PotentialTargets::PotentialTargets(const CStack *attacker, const HypotheticChang
 	}
 }
 
+AttackPossibility CBattleAI::lookAhead(const CStack * stack, const PotentialTargets &targets, int timeLimitMs, int depthLimit) const
+{
+	//search decides only which enemy to attack, best way to attack him is still chosen by targets
+	std::vector<AttackPossibility> candidates;
+	for(auto &ap : targets.possibleAttacks)
+	{
+		auto sameEnemy = [&](const AttackPossibility &c) { return c.enemy == ap.enemy; };
+		auto it = boost::find_if(candidates, sameEnemy);
+		if(it == candidates.end())
+			candidates.push_back(ap);
+		else if(ap.attackValue() > it->attackValue())
+			*it = ap;
+	}
+	if(candidates.size() < 2)
+		return targets.bestAction();
+
+	SimulatedBattle battle(*cb, stack);
+	if(battle.indexOf(stack) < 0)
+		return targets.bestAction();
+
+	std::vector<SimulatedAction> firstActions;
+	for(auto &ap : candidates)
+	{
+		SimulatedAction action = {battle.indexOf(ap.enemy), ap.attack.shooting, ap.attack.shooting ? stack->position : ap.tile};
+		if(action.target < 0)
+			return targets.bestAction();
+		firstActions.push_back(action);
+	}
+
+	const int chosen = BattleSearch::chooseAction(battle, firstActions, timeLimitMs, depthLimit);
+	if(chosen < 0)
+		return targets.bestAction();
+
+	return candidates[chosen];
+}
+
 AttackPossibility PotentialTargets::bestAction() const
 {
 	if(possibleAttacks.empty())
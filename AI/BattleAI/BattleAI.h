@@ -13,7 +13,7 @@ public:
 	const CStack *stack;
 	mutable std::vector<Bonus> bonusesToAdd;
 
-	virtual const TBonusListPtr getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr, const std::string &cachingStr = "") const override;
+	virtual const TBonusListPtr getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr, const BonusCacheKey &cachingKey = BonusCacheKey()) const override;
 };
 
 struct EnemyInfo
@@ -148,6 +148,7 @@ public:
 	boost::optional<BattleAction> considerFleeingOrSurrendering();
 
 	void attemptCastingSpell();
+	AttackPossibility lookAhead(const CStack * stack, const PotentialTargets &targets, int timeLimitMs, int depthLimit) const; //picks enemy to attack by simulating next few turns
 	std::vector<BattleHex> getTargetsToConsider(const CSpell *spell) const;
 };
 
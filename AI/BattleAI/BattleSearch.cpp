@@ -0,0 +1,312 @@
+#include "StdInc.h"
+#include "BattleSearch.h"
+#include "../../lib/BattleState.h"
+#include "../../lib/CCreatureHandler.h"
+#include "../../lib/CThreadHelper.h"
+#include "../../CCallback.h"
+
+int SimulatedStack::health() const
+{
+	return count ? (count - 1) * maxHealth + firstHPleft : 0;
+}
+
+void SimulatedStack::takeDamage(int damage)
+{
+	const int left = std::max(0, health() - damage);
+	count = (left + maxHealth - 1) / maxHealth;
+	firstHPleft = count ? left - (count - 1) * maxHealth : 0;
+}
+
+SimulatedBattle::SimulatedBattle(const CPlayerBattleCallback &cb, const CStack *activeStack)
+{
+	for(const CStack *s : cb.battleGetStacks())
+	{
+		if(!s->position.isValid()) //turrets
+			continue;
+
+		SimulatedStack ss;
+		ss.stack = s;
+		ss.attackerOwned = s->attackerOwned;
+		ss.shooter = s->hasBonusOfType(Bonus::SHOOTER);
+		ss.blocksRetaliation = s->hasBonusOfType(Bonus::BLOCKS_RETALIATION);
+		ss.doubleWide = s->doubleWide();
+		ss.speed = s->Speed();
+		ss.count = s->count;
+		ss.firstHPleft = s->firstHPleft;
+		ss.maxHealth = std::max<int>(1, s->MaxHealth());
+		ss.value = s->getCreature()->AIValue;
+		ss.shots = s->shots;
+		if(s->hasBonusOfType(Bonus::UNLIMITED_RETALIATIONS))
+			ss.retaliations = ss.retaliationsPerRound = std::numeric_limits<int>::max();
+		else
+		{
+			ss.retaliationsPerRound = 1 + s->valOfBonuses(Bonus::ADDITIONAL_RETALIATION);
+			ss.retaliations = s->counterAttacks;
+		}
+		ss.moved = s != activeStack && !s->willMove();
+		ss.position = s->position;
+		stacks.push_back(ss);
+	}
+	active = indexOf(activeStack);
+
+	auto dmg = std::make_shared<SimulatedDamage>();
+	dmg->stacks = stacks.size();
+	dmg->melee.resize(stacks.size() * stacks.size());
+	dmg->ranged.resize(stacks.size() * stacks.size());
+	for(size_t i = 0; i < stacks.size(); i++)
+	{
+		for(size_t j = 0; j < stacks.size(); j++)
+		{
+			if(stacks[i].attackerOwned == stacks[j].attackerOwned)
+				continue;
+
+			auto perCreature = [&](bool shooting) -> double
+			{
+				const auto estimation = cb.battleEstimateDamage(BattleAttackInfo(stacks[i].stack, stacks[j].stack, shooting));
+				return (estimation.first + estimation.second) / 2.0 / stacks[i].count;
+			};
+			dmg->melee[i * stacks.size() + j] = perCreature(false);
+			if(stacks[i].shooter)
+				dmg->ranged[i * stacks.size() + j] = perCreature(true);
+		}
+	}
+	damage = dmg;
+}
+
+SimulatedBattle::SimulatedBattle()
+	: active(-1)
+{
+}
+
+int SimulatedBattle::indexOf(const CStack *stack) const
+{
+	for(size_t i = 0; i < stacks.size(); i++)
+		if(stacks[i].stack == stack)
+			return i;
+	return -1;
+}
+
+TBattleHexMask SimulatedBattle::occupiedHexes() const
+{
+	TBattleHexMask ret;
+	for(size_t i = 0; i < stacks.size(); i++)
+	{
+		const SimulatedStack &s = stacks[i];
+		if(i == (size_t)active || !s.count)
+			continue;
+
+		ret.set(s.position);
+		const BattleHex second(s.position + (s.attackerOwned ? -1 : 1));
+		if(s.doubleWide && second.isValid())
+			ret.set(second);
+	}
+	return ret;
+}
+
+std::vector<SimulatedAction> SimulatedBattle::possibleActions() const
+{
+	std::vector<SimulatedAction> ret;
+	const SimulatedStack &me = stacks[active];
+	const TBattleHexMask occupied = occupiedHexes();
+
+	bool enemyAdjacent = false;
+	for(auto &s : stacks)
+		if(s.count && s.attackerOwned != me.attackerOwned && BattleHex::getDistance(me.position, s.position) == 1)
+			enemyAdjacent = true;
+
+	for(size_t i = 0; i < stacks.size(); i++)
+	{
+		const SimulatedStack &enemy = stacks[i];
+		if(!enemy.count || enemy.attackerOwned == me.attackerOwned)
+			continue;
+
+		if(me.shooter && me.shots > 0 && !enemyAdjacent)
+		{
+			SimulatedAction shot = {static_cast<int>(i), true, me.position};
+			ret.push_back(shot);
+			continue;
+		}
+
+		//melee from the nearest free tile next to enemy, obstacles are not simulated
+		BattleHex tile;
+		for(BattleHex neighbour : enemy.position.neighbouringTiles())
+		{
+			const int distance = BattleHex::getDistance(me.position, neighbour);
+			if((neighbour == me.position || (!occupied[neighbour] && distance <= me.speed))
+				&& (!tile.isValid() || distance < BattleHex::getDistance(me.position, tile)))
+			{
+				tile = neighbour;
+			}
+		}
+		if(tile.isValid())
+		{
+			SimulatedAction attack = {static_cast<int>(i), false, tile};
+			ret.push_back(attack);
+		}
+	}
+
+	if(ret.empty())
+	{
+		//nobody to attack, move as close to the nearest enemy as possible
+		auto distanceToEnemy = [&](BattleHex hex) -> int
+		{
+			int best = std::numeric_limits<int>::max();
+			for(auto &s : stacks)
+				if(s.count && s.attackerOwned != me.attackerOwned)
+					vstd::amin(best, BattleHex::getDistance(hex, s.position));
+			return best;
+		};
+
+		SimulatedAction move = {-1, false, me.position};
+		for(si16 hex = 0; hex < GameConstants::BFIELD_SIZE; hex++)
+		{
+			if(BattleHex(hex).isAvailable() && !occupied[hex] && BattleHex::getDistance(me.position, hex) <= me.speed
+				&& distanceToEnemy(hex) < distanceToEnemy(move.tile))
+			{
+				move.tile = hex;
+			}
+		}
+		ret.push_back(move);
+	}
+	return ret;
+}
+
+void SimulatedBattle::attack(int attacker, int defender, bool shooting)
+{
+	SimulatedStack &att = stacks[attacker], &def = stacks[defender];
+	const auto &table = shooting ? damage->ranged : damage->melee;
+	def.takeDamage(table[attacker * damage->stacks + defender] * att.count);
+
+	if(shooting)
+		att.shots--;
+	else if(def.count && def.retaliations > 0 && !att.blocksRetaliation)
+	{
+		def.retaliations--;
+		att.takeDamage(damage->melee[defender * damage->stacks + attacker] * def.count);
+	}
+}
+
+void SimulatedBattle::apply(const SimulatedAction &action)
+{
+	stacks[active].position = action.tile;
+	if(action.target >= 0)
+		attack(active, action.target, action.shooting);
+	stacks[active].moved = true;
+	nextStack();
+}
+
+void SimulatedBattle::nextStack()
+{
+	//fastest stack which hasn't acted yet, new round starts when all have acted
+	for(int round = 0; round < 2; round++)
+	{
+		active = -1;
+		for(size_t i = 0; i < stacks.size(); i++)
+			if(stacks[i].count && !stacks[i].moved && (active < 0 || stacks[i].speed > stacks[active].speed))
+				active = i;
+
+		if(active >= 0)
+			return;
+
+		for(auto &s : stacks)
+		{
+			s.moved = false;
+			s.retaliations = s.retaliationsPerRound;
+		}
+	}
+}
+
+int SimulatedBattle::evaluate(bool attackerSide) const
+{
+	si64 ret = 0;
+	for(auto &s : stacks)
+	{
+		const si64 value = (si64)s.value * s.health() / s.maxHealth;
+		ret += (s.attackerOwned == attackerSide) ? value : -value;
+	}
+	return static_cast<int>(ret);
+}
+
+bool SimulatedBattle::finished() const
+{
+	bool alive[2] = {false, false};
+	for(auto &s : stacks)
+		if(s.count)
+			alive[s.attackerOwned] = true;
+	return !alive[0] || !alive[1];
+}
+
+int BattleSearch::minimax(const SimulatedBattle &battle, int depth, int alpha, int beta, bool side, TClock::time_point deadline, bool &timedOut)
+{
+	if(depth == 0 || battle.finished())
+		return battle.evaluate(side);
+	if(TClock::now() > deadline)
+	{
+		timedOut = true;
+		return 0;
+	}
+
+	const bool maximizing = battle.stacks[battle.active].attackerOwned == side;
+	int best = maximizing ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
+	for(auto &action : battle.possibleActions())
+	{
+		SimulatedBattle next = battle;
+		next.apply(action);
+		const int value = minimax(next, depth - 1, alpha, beta, side, deadline, timedOut);
+		if(timedOut)
+			return 0;
+
+		if(maximizing)
+		{
+			vstd::amax(best, value);
+			vstd::amax(alpha, best);
+		}
+		else
+		{
+			vstd::amin(best, value);
+			vstd::amin(beta, best);
+		}
+		if(beta <= alpha)
+			break;
+	}
+	return best;
+}
+
+int BattleSearch::chooseAction(const SimulatedBattle &battle, const std::vector<SimulatedAction> &firstActions, int timeLimitMs, int depthLimit)
+{
+	const auto deadline = depthLimit > 0 ? TClock::time_point::max() : TClock::now() + std::chrono::milliseconds(timeLimitMs);
+	const bool side = battle.stacks[battle.active].attackerOwned;
+	const ui32 threads = std::max((ui32)1, boost::thread::hardware_concurrency());
+	const int maxDepth = 4 * battle.stacks.size(); //deeper search is unlikely to fit in time anyway
+
+	//iterative deepening, results of depth that didn't finish in time are not used
+	//depth counts actions after the first one, fixed depth search runs only its last iteration
+	int best = -1;
+	for(int depth = depthLimit > 0 ? depthLimit - 1 : 0; depth < (depthLimit > 0 ? depthLimit : maxDepth); depth++)
+	{
+		std::vector<int> values(firstActions.size());
+		std::vector<ui8> timedOut(firstActions.size(), false);
+		std::vector<Task> tasks;
+		for(size_t i = 0; i < firstActions.size(); i++)
+		{
+			tasks.push_back([&, i]
+			{
+				SimulatedBattle next = battle;
+				next.apply(firstActions[i]);
+				bool outOfTime = false;
+				values[i] = minimax(next, depth, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), side, deadline, outOfTime);
+				timedOut[i] = outOfTime;
+			});
+		}
+
+		CThreadHelper th(&tasks, threads);
+		th.run();
+		if(vstd::contains(timedOut, true))
+			break;
+
+		//first of equally good actions is taken, so the choice doesn't depend on threads
+		best = boost::max_element(values) - values.begin();
+		logAi->traceStream() << boost::format("Battle search: depth %d, best action %d with value %d") % depth % best % values[best];
+	}
+	return best;
+}
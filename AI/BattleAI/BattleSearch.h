@@ -0,0 +1,77 @@
+#pragma once
+
+#include "../../lib/BattleHex.h"
+
+class CStack;
+class CPlayerBattleCallback;
+
+/// Stack in simulated battle, plain values only so that whole battle can be copied in a moment
+struct SimulatedStack
+{
+	const CStack *stack; //original stack, only for mapping results back
+	bool attackerOwned;
+	bool shooter;
+	bool blocksRetaliation;
+	bool doubleWide;
+	int speed;
+	int count, firstHPleft, maxHealth;
+	int value; //AI value of one creature
+	int shots;
+	int retaliations, retaliationsPerRound;
+	bool moved; //already acted in this round
+	BattleHex position;
+
+	int health() const;
+	void takeDamage(int damage);
+};
+
+struct SimulatedAction
+{
+	int target; //index of attacked stack, -1 if stack only moves
+	bool shooting;
+	BattleHex tile; //where stack stands after action
+};
+
+/// Damage of every stack against every enemy, estimated once from real battle and shared by all simulated states
+struct SimulatedDamage
+{
+	int stacks;
+	std::vector<double> melee, ranged; //per one attacking creature, [attacker * stacks + defender]
+};
+
+/// Compact battle state for lookahead, ignores spells, obstacles and most of special abilities
+class SimulatedBattle
+{
+public:
+	std::vector<SimulatedStack> stacks;
+	shared_ptr<const SimulatedDamage> damage;
+	int active; //index of stack which acts now
+
+	SimulatedBattle(const CPlayerBattleCallback &cb, const CStack *activeStack);
+	SimulatedBattle(); //empty battle, stacks, damage and active stack are set up by caller
+
+	int indexOf(const CStack *stack) const; //-1 if stack is not simulated
+	std::vector<SimulatedAction> possibleActions() const; //of active stack, never empty
+	void apply(const SimulatedAction &action); //active stack acts and turn passes to next one
+	void nextStack(); //fastest living stack that hasn't acted yet becomes active, starts new round if needed
+	int evaluate(bool attackerSide) const; //value of given side army minus value of the other one
+	bool finished() const; //one of sides has no stacks left
+
+private:
+	void attack(int attacker, int defender, bool shooting);
+	TBattleHexMask occupiedHexes() const;
+};
+
+/// Multi-ply minimax search over SimulatedBattle
+class BattleSearch
+{
+public:
+	typedef std::chrono::steady_clock TClock;
+
+	//alpha-beta minimax, side is the one for which value is maximised; timedOut is set if deadline passed and result is useless then
+	static int minimax(const SimulatedBattle &battle, int depth, int alpha, int beta, bool side, TClock::time_point deadline, bool &timedOut);
+
+	//returns index of best first action of active stack or -1 if search couldn't look even one action ahead in given time
+	//with positive depthLimit search goes exactly that many actions deep and time limit is ignored, so result doesn't depend on machine load
+	static int chooseAction(const SimulatedBattle &battle, const std::vector<SimulatedAction> &firstActions, int timeLimitMs, int depthLimit);
+};
@@ -302,12 +302,14 @@ Goals::TSubgoal FuzzyHelper::chooseSolution (Goals::TGoalVec vec)
 	if (vec.empty()) //no possibilities found
 		return sptr(Goals::Invalid());
 
-	//a trick to switch between heroes less often - calculatePaths is costly
-	auto sortByHeroes = [](const Goals::TSubgoal & lhs, const Goals::TSubgoal & rhs) -> bool
+	//evaluation needs paths of every involved hero - calculatePaths is costly, so do it for all of them at once
+	std::vector<const CGHeroInstance *> heroes;
+	for (auto g : vec)
 	{
-		return lhs->hero.h < rhs->hero.h;
-	};
-	boost::sort (vec, sortByHeroes);
+		if (g->hero && !vstd::contains(heroes, g->hero.get()))
+			heroes.push_back(g->hero.get());
+	}
+	cb->calculatePaths(heroes);
 
 	for (auto g : vec)
 	{
@@ -480,8 +482,8 @@ float FuzzyHelper::evaluate (Goals::ClearWayTo & g)
 	if (!g.hero.h)
 		throw cannotFulfillGoalException("ClearWayTo called without hero!");
 
-	SectorMap sm(g.hero);
-	int3 t = sm.firstTileToGet(g.hero, g.tile);
+	auto sm = ai->getSectorMap();
+	int3 t = sm->firstTileToGet(g.hero, g.tile);
 
 	if (t.valid())
 	{
@@ -4,6 +4,7 @@
 #include "Fuzzy.h"
 
 #include "../../lib/UnlockGuard.h"
+#include "../../lib/CProfiler.h"
 #include "../../lib/mapObjects/MapObjects.h"
 #include "../../lib/CConfigHandler.h"
 #include "../../lib/CHeroHandler.h"
@@ -69,6 +70,22 @@ const unsigned char &retreiveTileN(const std::vector< std::vector< std::vector<u
 	return vectors[pos.x][pos.y][pos.z];
 }
 
+bool isShoreTile(crint3 pos)
+{
+	const TerrainTile *t = cb->getTile(pos, false);
+	if(!t)
+		return false;
+
+	bool shore = false;
+	foreach_neighbour(pos, [&](crint3 neighPos)
+	{
+		const TerrainTile *nt = cb->getTile(neighPos, false);
+		if(nt && nt->isWater() != t->isWater())
+			shore = true;
+	});
+	return shore;
+}
+
 void foreach_tile(std::vector< std::vector< std::vector<unsigned char> > > &vectors, std::function<void(unsigned char &in)> foo)
 {
 	for(auto & vector : vectors)
@@ -96,6 +113,7 @@ VCAI::VCAI(void)
 	LOG_TRACE(logAi);
 	makingTurn = nullptr;
 	destinationTeleport = ObjectInstanceID();
+	sectorMapValid = false;
 }
 
 VCAI::~VCAI(void)
@@ -115,6 +133,12 @@ void VCAI::heroMoved(const TryMoveHero & details)
 	NET_EVENT_HANDLER;
 
 	validateObject(details.id); //enemy hero may have left visible area
+	//sectors don't depend on hero positions, but heroes and boats on shore change which tiles can be used for (dis)embarking
+	if(details.result != TryMoveHero::FAILED
+		&& (isShoreTile(CGHeroInstance::convertPosition(details.start, false)) || isShoreTile(CGHeroInstance::convertPosition(details.end, false))))
+	{
+		sectorMapValid = false;
+	}
 
 	if(details.result == TryMoveHero::TELEPORTATION)
 	{
@@ -286,6 +310,7 @@ void VCAI::tileHidden(const std::unordered_set<int3, ShashInt3> &pos)
 	NET_EVENT_HANDLER;
 
 	validateVisitableObjs();
+	sectorMapValid = false;
 }
 
 void VCAI::tileRevealed(const std::unordered_set<int3, ShashInt3> &pos)
@@ -296,6 +321,7 @@ void VCAI::tileRevealed(const std::unordered_set<int3, ShashInt3> &pos)
 		for(const CGObjectInstance *obj : myCb->getVisitableObjs(tile))
 			addVisitableObj(obj);
 
+	sectorMapValid = false;
 	clearHeroesUnableToExplore();
 }
 
@@ -377,6 +403,7 @@ void VCAI::newObject(const CGObjectInstance * obj)
 	if(obj->isVisitable())
 		addVisitableObj(obj);
 
+	sectorMapValid = false;
 	clearHeroesUnableToExplore();
 }
 
@@ -387,6 +414,7 @@ void VCAI::objectRemoved(const CGObjectInstance *obj)
 
 	erase_if_present(visitableObjs, obj);
 	erase_if_present(alreadyVisited, obj);
+	sectorMapValid = false;
 
 	for (auto h : cb->getHeroesInfo())
 		unreserveObject(h, obj);
@@ -697,6 +725,7 @@ void makePossibleUpgrades(const CArmedInstance *obj)
 void VCAI::makeTurn()
 {
 	MAKING_TURN;
+	PROFILE_ZONE("VCAI::makeTurn");
 	boost::shared_lock<boost::shared_mutex> gsLock(cb->getGsMutex());
 	setThreadName("VCAI::makeTurn");
 
@@ -1239,7 +1268,7 @@ void VCAI::buildStructure(const CGTownInstance * t)
 		return;
 }
 
-bool VCAI::isGoodForVisit(const CGObjectInstance *obj, HeroPtr h, SectorMap &sm)
+bool VCAI::isGoodForVisit(const CGObjectInstance *obj, HeroPtr h, const SectorMap &sm)
 {
 	const int3 pos = obj->visitablePos();
 	if (canReachTile(h.get(), sm.firstTileToGet(h, obj->visitablePos())) &&
@@ -1266,10 +1295,10 @@ std::vector<const CGObjectInstance *> VCAI::getPossibleDestinations(HeroPtr h)
 {
 	validateVisitableObjs();
 	std::vector<const CGObjectInstance *> possibleDestinations;
-	SectorMap sm(h);
+	auto sm = getSectorMap();
 	for(const CGObjectInstance *obj : visitableObjs)
 	{
-		if (isGoodForVisit(obj, h, sm))
+		if (isGoodForVisit(obj, h, *sm))
 		{
 			possibleDestinations.push_back(obj);
 		}
@@ -1280,6 +1309,19 @@ std::vector<const CGObjectInstance *> VCAI::getPossibleDestinations(HeroPtr h)
 	return possibleDestinations;
 }
 
+shared_ptr<const SectorMap> VCAI::getSectorMap()
+{
+	boost::unique_lock<boost::mutex> lock(sectorMapMx);
+	if(!sectorMap || !sectorMapValid)
+	{
+		sectorMapValid = true; //set before reading the map, so changes meanwhile will invalidate it again
+		auto fresh = std::make_shared<SectorMap>();
+		fresh->update();
+		sectorMap = fresh;
+	}
+	return sectorMap;
+}
+
 bool VCAI::canReachTile (const CGHeroInstance * h, int3 t)
 {
 	if (t.valid())
@@ -1723,7 +1765,7 @@ bool VCAI::moveHeroToTile(int3 dst, HeroPtr h)
 	else
 	{
 		CGPath path;
-		cb->getPathsInfo(h.get())->getPath(dst, path);
+		cb->getPath(h.get(), dst, path);
 		if(path.nodes.empty())
 		{
             logAi->errorStream() << "Hero " << h->name << " cannot reach " << dst;
@@ -2312,7 +2354,13 @@ void VCAI::striveToQuest (const QuestInfo &q)
 
 void VCAI::performTypicalActions()
 {
-	for(auto h : getUnblockedHeroes())
+	auto heroes = getUnblockedHeroes();
+	std::vector<const CGHeroInstance *> heroesToCalculate;
+	for(auto h : heroes)
+		heroesToCalculate.push_back(h.get());
+	cb->calculatePaths(heroesToCalculate); //wander asks for paths of its hero many times
+
+	for(auto h : heroes)
 	{
         logAi->debugStream() << boost::format("Looking into %s, MP=%d") % h->name.c_str() % h->movement;
 		makePossibleUpgrades(*h);
@@ -2411,7 +2459,7 @@ int3 VCAI::explorationNewPoint(HeroPtr h)
 int3 VCAI::explorationDesperate(HeroPtr h)
 {
     //logAi->debugStream() << "Looking for an another place for exploration...";
-	SectorMap sm(h);
+	auto sm = getSectorMap();
 	int radius = h->getSightRadious();
 	
 	std::vector<std::vector<int3> > tiles; //tiles[distance_to_fow]
@@ -2440,7 +2488,7 @@ int3 VCAI::explorationDesperate(HeroPtr h)
 			if (!howManyTilesWillBeDiscovered(tile, radius, cbp)) //avoid costly checks of tiles that don't reveal much
 				continue;
 
-			auto t = sm.firstTileToGet(h, tile);
+			auto t = sm->firstTileToGet(h, tile);
 			if (t.valid())
 			{
 				ui64 ourDanger = evaluateDanger(t, h.h);
@@ -2778,17 +2826,6 @@ bool AIStatus::channelProbing()
 	return ongoingChannelProbing;
 }
 
-SectorMap::SectorMap()
-{
-	update();
-}
-
-SectorMap::SectorMap(HeroPtr h)
-{
-	update();
-	makeParentBFS(h->visitablePos());
-}
-
 bool markIfBlocked(ui8 &sec, crint3 pos, const TerrainTile *t)
 {
 	if(t->blocked && !t->visitable)
@@ -2819,13 +2856,14 @@ void SectorMap::update()
 				exploreNewSector(pos, curSector++, cbp);
 		}
 	});
-	valid = true;
 }
 
 void SectorMap::clear()
 {
 	sector = cb->getVisibilityMap();
-	valid = false;
+	sizes = cb->getMapSize();
+	infoOnSectors.clear();
+	parentTrees.clear();
 }
 
 void SectorMap::exploreNewSector(crint3 pos, int num, CCallback * cbp)
@@ -2880,7 +2918,7 @@ void SectorMap::exploreNewSector(crint3 pos, int num, CCallback * cbp)
 	removeDuplicates(s.embarkmentPoints);
 }
 
-void SectorMap::write(crstring fname)
+void SectorMap::write(crstring fname) const
 {
 	std::ofstream out(fname);
 	for(int k = 0; k < cb->getMapSize().z; k++)
@@ -3019,7 +3057,7 @@ bool shouldVisit(HeroPtr h, const CGObjectInstance * obj)
 	return true;
 }
 
-int3 SectorMap::firstTileToGet(HeroPtr h, crint3 dst)
+int3 SectorMap::firstTileToGet(HeroPtr h, crint3 dst) const
 /*
 this functions returns one target tile or invalid tile. We will use it to poll possible destinations
 For ship construction etc, another function (goal?) is needed
@@ -3030,8 +3068,8 @@ For ship construction etc, another function (goal?) is needed
 	int sourceSector = retreiveTile(h->visitablePos()),
 		destinationSector = retreiveTile(dst);
 
-	const Sector *src = &infoOnSectors[sourceSector],
-		*dest = &infoOnSectors[destinationSector];
+	const Sector *src = getSector(sourceSector),
+		*dest = getSector(destinationSector);
 
 	if(sourceSector != destinationSector) //use ships, shipyards etc..
 	{
@@ -3048,7 +3086,7 @@ For ship construction etc, another function (goal?) is needed
 
 			for(int3 ep : s->embarkmentPoints)
 			{
-				Sector *neigh = &infoOnSectors[retreiveTile(ep)];
+				const Sector *neigh = getSector(retreiveTile(ep));
 				//preds[s].push_back(neigh);
 				if(!preds[neigh])
 				{
@@ -3063,7 +3101,7 @@ For ship construction etc, another function (goal?) is needed
 				if (gatePair != ai->knownSubterraneanGates.end())
 				{
 					//check the other side of gate
-					Sector *neigh = &infoOnSectors[retreiveTile(gatePair->second->visitablePos())];
+					const Sector *neigh = getSector(retreiveTile(gatePair->second->visitablePos()));
 					if(!preds[neigh]) //if we didn't come into this sector yet
 					{
 						preds[neigh] = s; //it becomes our new target sector
@@ -3220,10 +3258,11 @@ For ship construction etc, another function (goal?) is needed
 	return ret;
 }
 
-int3 SectorMap::findFirstVisitableTile (HeroPtr h, crint3 dst)
+int3 SectorMap::findFirstVisitableTile (HeroPtr h, crint3 dst) const
 {
 	int3 ret(-1,-1,-1);
 	int3 curtile = dst;
+	auto tree = getParentTree(h);
 
 	while(curtile != h->visitablePos())
 	{
@@ -3239,11 +3278,11 @@ int3 SectorMap::findFirstVisitableTile (HeroPtr h, crint3 dst)
 		}
 		else
 		{
-			auto i = parent.find(curtile);
-			if(i != parent.end())
+			int3 parent = tree->parent[tileIndex(curtile)];
+			if(parent.valid())
 			{
-				assert(curtile != i->second);
-				curtile = i->second;
+				assert(curtile != parent);
+				curtile = parent;
 			}
 			else
 			{
@@ -3255,9 +3294,23 @@ int3 SectorMap::findFirstVisitableTile (HeroPtr h, crint3 dst)
 	return ret;
 }
 
-void SectorMap::makeParentBFS(crint3 source)
+shared_ptr<const SectorMap::ParentTree> SectorMap::getParentTree(HeroPtr h) const
+{
+	boost::unique_lock<boost::mutex> lock(parentTreesMx);
+	auto & tree = parentTrees[h.get()];
+	if(!tree || tree->source != h->visitablePos())
+	{
+		auto fresh = std::make_shared<ParentTree>();
+		makeParentBFS(h->visitablePos(), *fresh);
+		tree = fresh; //threads still walking the old tree keep it alive
+	}
+	return tree;
+}
+
+void SectorMap::makeParentBFS(crint3 source, ParentTree &tree) const
 {
-	parent.clear();
+	tree.source = source;
+	tree.parent.assign(sizes.x * sizes.y * sizes.z, int3(-1, -1, -1));
 
 	int mySector = retreiveTile(source);
 	std::queue<int3> toVisit;
@@ -3266,18 +3319,19 @@ void SectorMap::makeParentBFS(crint3 source)
 	{
 		int3 curPos = toVisit.front();
 		toVisit.pop();
-		ui8 &sec = retreiveTile(curPos);
+		const ui8 sec = retreiveTile(curPos);
 		assert(sec == mySector); //consider only tiles from the same sector
 		UNUSED(sec);
 	
 		foreach_neighbour(curPos, [&](crint3 neighPos)
 		{
-			if(retreiveTile(neighPos) == mySector && !vstd::contains(parent, neighPos))
+			int3 &parent = tree.parent[tileIndex(neighPos)];
+			if(retreiveTile(neighPos) == mySector && !parent.valid())
 			{
 				if (cb->canMoveBetween(curPos, neighPos))
 				{
 					toVisit.push(neighPos);
-					parent[neighPos] = curPos;
+					parent = curPos;
 				}
 			}
 		});
@@ -3289,3 +3343,20 @@ unsigned char & SectorMap::retreiveTile(crint3 pos)
 	return retreiveTileN(sector, pos);
 }
 
+unsigned char SectorMap::retreiveTile(crint3 pos) const
+{
+	return retreiveTileN(sector, pos);
+}
+
+const SectorMap::Sector * SectorMap::getSector(int num) const
+{
+	static const Sector unknownSector;
+	auto it = infoOnSectors.find(num);
+	return it != infoOnSectors.end() ? &it->second : &unknownSector;
+}
+
+int SectorMap::tileIndex(crint3 pos) const
+{
+	return (pos.x * sizes.y + pos.y) * sizes.z + pos.z;
+}
+
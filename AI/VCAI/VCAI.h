@@ -89,26 +89,38 @@ struct SectorMap
 		}
 	};
 
-	bool valid; //some kind of lazy eval
-	std::map<int3, int3> parent;
+	//tiles of hero's sector leading back to him, result of BFS from his position
+	struct ParentTree
+	{
+		int3 source;
+		std::vector<int3> parent; //[tile index] -> previous tile, invalid if there is none
+	};
+
+	int3 sizes;
 	std::vector<std::vector<std::vector<unsigned char>>> sector;
 	//std::vector<std::vector<std::vector<unsigned char>>> pathfinderSector;
 
 	std::map<int, Sector> infoOnSectors;
 
-	SectorMap();
-	SectorMap(HeroPtr h);
+	//computed on demand; sector map is shared by AI threads, so it's the only part changed after update()
+	mutable boost::mutex parentTreesMx;
+	mutable std::map<const CGHeroInstance *, shared_ptr<const ParentTree>> parentTrees;
+
 	void update();
 	void clear();
 	void exploreNewSector(crint3 pos, int num, CCallback * cbp);
-	void write(crstring fname);
+	void write(crstring fname) const;
 
 	unsigned char &retreiveTile(crint3 pos);
+	unsigned char retreiveTile(crint3 pos) const;
+	int tileIndex(crint3 pos) const;
+	const Sector * getSector(int num) const; //empty sector for tiles that are not part of any
 
-	void makeParentBFS(crint3 source);
+	shared_ptr<const ParentTree> getParentTree(HeroPtr h) const; //recalculated if hero moved since last time
+	void makeParentBFS(crint3 source, ParentTree &tree) const;
 
-	int3 firstTileToGet(HeroPtr h, crint3 dst); //if h wants to reach tile dst, which tile he should visit to clear the way?
-	int3 findFirstVisitableTile(HeroPtr h, crint3 dst);
+	int3 firstTileToGet(HeroPtr h, crint3 dst) const; //if h wants to reach tile dst, which tile he should visit to clear the way?
+	int3 findFirstVisitableTile(HeroPtr h, crint3 dst) const;
 };
 
 //Set of buildings for different goals. Does not include any prerequisites.
@@ -157,6 +169,12 @@ public:
 	std::set<const CGObjectInstance *> alreadyVisited;
 	std::set<const CGObjectInstance *> reservedObjs; //to be visited by specific hero
 
+	//shared by all our heroes and never changed once built, map events only mark it outdated
+	//and next getSectorMap() publishes a new one, so threads still using the old one are not affected
+	shared_ptr<const SectorMap> sectorMap;
+	std::atomic<bool> sectorMapValid; //cleared by event handlers on network thread
+	boost::mutex sectorMapMx; //helper threads of requestActionASAP may ask for the map too, only one of them rebuilds it
+
 	TResources saving;
 
 	AIStatus status;
@@ -267,7 +285,8 @@ public:
 	void striveToQuest (const QuestInfo &q);
 
 	void recruitHero(const CGTownInstance * t, bool throwing = false);
-	bool isGoodForVisit(const CGObjectInstance *obj, HeroPtr h, SectorMap &sm);
+	bool isGoodForVisit(const CGObjectInstance *obj, HeroPtr h, const SectorMap &sm);
+	shared_ptr<const SectorMap> getSectorMap(); //up-to-date sectors of map as we know it
 	std::vector<const CGObjectInstance *> getPossibleDestinations(HeroPtr h);
 	void buildStructure(const CGTownInstance * t);
 	//void recruitCreatures(const CGTownInstance * t);
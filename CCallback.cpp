@@ -297,7 +297,12 @@ int CCallback::getMovementCost(const CGHeroInstance * hero, int3 dest)
 
 const CPathsInfo * CCallback::getPathsInfo(const CGHeroInstance *h)
 {
-	return cl->getPathsInfo(h);
+	return cl->getPathsInfo(*player, h);
+}
+
+bool CCallback::getPath(const CGHeroInstance *h, const int3 &dst, CGPath &out)
+{
+	return cl->getPath(*player, h, dst, out);
 }
 
 int3 CCallback::getGuardingCreaturePosition(int3 tile)
@@ -313,6 +318,11 @@ void CCallback::calculatePaths( const CGHeroInstance *hero, CPathsInfo &out)
 	gs->calculatePaths(hero, out);
 }
 
+void CCallback::calculatePaths(const std::vector<const CGHeroInstance *> &heroes)
+{
+	cl->calculatePaths(*player, heroes);
+}
+
 void CCallback::dig( const CGObjectInstance *hero )
 {
 	DigWithHero dwh;
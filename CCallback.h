@@ -107,8 +107,10 @@ public:
 	virtual int getMovementCost(const CGHeroInstance * hero, int3 dest);
 	virtual int3 getGuardingCreaturePosition(int3 tile);
 	virtual const CPathsInfo * getPathsInfo(const CGHeroInstance *h);
+	virtual bool getPath(const CGHeroInstance *h, const int3 &dst, CGPath &out); //for one-off queries, faster than getPathsInfo when paths of hero aren't calculated yet
 
 	virtual void calculatePaths(const CGHeroInstance *hero, CPathsInfo &out);
+	virtual void calculatePaths(const std::vector<const CGHeroInstance *> &heroes); //calculates paths of all given heroes at once, then getPathsInfo for them is instant until something changes
 
 	//Set of metrhods that allows adding more interfaces for this player that'll receive game event call-ins.
 	void registerGameInterface(shared_ptr<IGameEventsReceiver> gameEvents);
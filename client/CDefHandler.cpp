@@ -168,6 +168,7 @@ SDL_Surface * CDefHandler::getSprite (int SIndex, const ui8 * FDef, const SDL_Co
 	if (add==4)
 		add=0;
 
+	boost::unique_lock<boost::mutex> surfaceLock(CSDL_Ext::surfaceMx); //giveDef is called by parallel graphics loading
 	ret = SDL_CreateRGBSurface(SDL_SWSURFACE, FullWidth, FullHeight, 8, 0, 0, 0, 0);
 	
 	if(nullptr == ret)
@@ -198,6 +199,7 @@ SDL_Surface * CDefHandler::getSprite (int SIndex, const ui8 * FDef, const SDL_Co
 	}
 	
 	#endif
+	surfaceLock.unlock(); //decoding below writes only to pixels of our own surface
 
 	int ftcp=0;
 
@@ -362,6 +364,7 @@ SDL_Surface * CDefHandler::getSprite (int SIndex, const ui8 * FDef, const SDL_Co
 		break;
 	}
 
+	surfaceLock.lock();
 	SDL_Color ttcol = ret->format->palette->colors[0];
 	#ifdef VCMI_SDL1
 	Uint32 keycol = SDL_MapRGBA(ret->format, ttcol.r, ttcol.b, ttcol.g, ttcol.unused);	
@@ -40,6 +40,7 @@
 #include "gui/CGuiHandler.h"
 #include "../lib/logging/CBasicLogConfigurator.h"
 #include "../lib/CondSh.h"
+#include "../lib/CProfiler.h"
 
 #ifdef VCMI_WINDOWS
 #include "SDL_syswm.h"
@@ -135,6 +136,7 @@ void startGameFromFile(const bfs::path &fname)
 
 void init()
 {
+	PROFILE_ZONE("Client initialization");
 	CStopWatch tmh, pomtime;
 
 	loadDLLClasses();
@@ -147,15 +149,14 @@ void init()
 	{
 		pomtime.getDiff();
 		CCS->curh = new CCursorHandler;
-		graphics = new Graphics(); // should be before curh->init()
+		{
+			PROFILE_ZONE("Graphics");
+			graphics = new Graphics(); // should be before curh->init()
+		}
 
 		CCS->curh->initCursor();
 		CCS->curh->show();
 		logGlobal->infoStream()<<"Screen handler: "<<pomtime.getDiff();
-		pomtime.getDiff();
-
-		graphics->loadHeroAnims();
-		logGlobal->infoStream()<<"\tMain graphics: "<<pomtime.getDiff();
 		logGlobal->infoStream()<<"Initializing game graphics: "<<tmh.getDiff();
 
 		CMessage::init();
@@ -221,6 +222,8 @@ int main(int argc, char** argv)
 		("help,h", "display help and exit")
 		("version,v", "display version information and exit")
 		("battle,b", po::value<std::string>(), "runs game in duel mode (battle-only")
+		("serverport", po::value<std::string>(), "port for started local server, allows running several games at once")
+		("resultsFile", po::value<std::string>(), "file to which the duel result and battle AI decision times will be appended")
 		("start", po::value<bfs::path>(), "starts game from saved StartInfo file")
 		("onlyAI", "runs without human player, all players will be default AI")
 		("noGUI", "runs without GUI, implies --onlyAI")
@@ -234,7 +237,8 @@ int main(int argc, char** argv)
         ("loadhumanplayerindices",po::value<std::vector<int>>(),"Indexes of human players (0=Red, etc.)")
         ("loadplayer", po::value<int>(),"specifies which player we are in multiplayer loaded games (0=Red, etc.)")
         ("loadserverip",po::value<std::string>(),"IP for loaded game server")
-        ("loadserverport",po::value<std::string>(),"port for loaded game server");
+        ("loadserverport",po::value<std::string>(),"port for loaded game server")
+		("profile", "records timeline of startup and turns to VCMI_Client_profile.json in Chrome trace format");
 
 	if(argc > 1)
 	{
@@ -284,12 +288,21 @@ int main(int argc, char** argv)
 	console->start();
 	atexit(dispose);
 
-	const bfs::path logPath = VCMIDirs::get().userCachePath() / "VCMI_Client_log.txt";
+	if(vm.count("serverport"))
+		CServerHandler::forcedPort = vm["serverport"].as<std::string>();
+	if(vm.count("resultsFile"))
+		CServerHandler::duelResultsFile = vm["resultsFile"].as<std::string>();
+
+	const std::string logName = vm.count("serverport") ? "VCMI_Client_log_" + CServerHandler::forcedPort + ".txt" : "VCMI_Client_log.txt";
+	const bfs::path logPath = VCMIDirs::get().userCachePath() / logName;
 	CBasicLogConfigurator logConfig(logPath, console);
     logConfig.configureDefault();
 	logGlobal->infoStream() << "Creating console and configuring logger: " << pomtime.getDiff();
 	logGlobal->infoStream() << "The log file will be saved to " << logPath;
 
+	if(vm.count("profile"))
+		CProfiler::start(VCMIDirs::get().userCachePath() / "VCMI_Client_profile.json");
+
     // Init filesystem and settings
 	preinitDLL(::console);
     settings.init();
@@ -446,6 +459,8 @@ int main(int argc, char** argv)
 #ifndef VCMI_NO_THREADED_LOAD
 	loading.join();
 #endif
+	if(!gNoGUI)
+		graphics->loadFonts(); //SDL_ttf may be used only by one thread, it's the main one
     logGlobal->infoStream()<<"Initialization of VCMI (together): "<<total.getDiff();
 
 	if(!vm.count("battle"))
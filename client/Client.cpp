@@ -34,6 +34,7 @@
 #include "CPreGame.h"
 #include "battle/CBattleInterface.h"
 #include "../lib/CThreadHelper.h"
+#include "../lib/CProfiler.h"
 #include "../lib/CScriptingModule.h"
 #include "../lib/registerTypes/RegisterTypes.h"
 #include "gui/CGuiHandler.h"
@@ -106,7 +107,7 @@ void CClient::init()
 {
 	hotSeat = false;
 	connectionHandler = nullptr;
-	pathInfo = nullptr;
+	pathCache.clear();
 	applier = new CApplier<CBaseForCLApply>;
 	registerTypesClientPacks1(*applier);
 	registerTypesClientPacks2(*applier);
@@ -115,6 +116,8 @@ void CClient::init()
 	gs = nullptr;
 	erm = nullptr;
 	terminate = false;
+	battleDecisions = 0;
+	battleDecisionsTime = 0;
 }
 
 CClient::CClient(void)
@@ -139,7 +142,17 @@ void CClient::waitForMoveAndSend(PlayerColor color)
 	{
 		setThreadName("CClient::waitForMoveAndSend");
 		assert(vstd::contains(battleints, color));
-		BattleAction ba = battleints[color]->activeStack(gs->curB->battleGetStackByID(gs->curB->activeStack, false));
+		const si64 decisionStart = CProfiler::now();
+		BattleAction ba;
+		{
+			PROFILE_ZONE("activeStack");
+			ba = battleints[color]->activeStack(gs->curB->battleGetStackByID(gs->curB->activeStack, false));
+		}
+		{
+			boost::unique_lock<boost::mutex> lock(decisionStatsMx);
+			battleDecisions++;
+			battleDecisionsTime += CProfiler::now() - decisionStart;
+		}
 		logNetwork->traceStream() << "Send battle action to server: " << ba;
 		MakeAction temp_action(ba);
 		sendRequest(&temp_action, color);
@@ -158,6 +171,22 @@ void CClient::waitForMoveAndSend(PlayerColor color)
     logNetwork->errorStream() << "We should not be here!";
 }
 
+void CClient::reportDuelStats()
+{
+	boost::unique_lock<boost::mutex> lock(decisionStatsMx);
+	const double averageTime = battleDecisions ? battleDecisionsTime / 1000.0 / battleDecisions : 0;
+	logGlobal->infoStream() << boost::format("Battle AI made %d decisions, %.3f ms on average") % battleDecisions % averageTime;
+
+	if(CServerHandler::duelResultsFile.empty())
+		return;
+
+	std::ofstream out(CServerHandler::duelResultsFile, std::ios::app);
+	if(out)
+		out << boost::format("decisions\t%d\t%d\n") % battleDecisions % battleDecisionsTime;
+	else
+		logGlobal->errorStream() << "Cannot open to write " << CServerHandler::duelResultsFile;
+}
+
 void CClient::run()
 {
 	setThreadName("CClient::run");
@@ -244,6 +273,7 @@ void CClient::endGame( bool closeConnection /*= true*/ )
 void CClient::loadGame(const std::string & fname, const bool server, const std::vector<int>& humanplayerindices, const int loadNumPlayers, int player_, const std::string & ipaddr, const std::string & port)
 {
     PlayerColor player(player_); //intentional shadowing
+	PROFILE_ZONE("CClient::loadGame");
 
     logNetwork->infoStream() <<"Loading procedure started!";
 
@@ -283,7 +313,7 @@ void CClient::loadGame(const std::string & fname, const bool server, const std::
         logNetwork->infoStream() << "Loaded common part of save " << tmh.getDiff();
 		const_cast<CGameInfo*>(CGI)->mh = new CMapHandler();
 		const_cast<CGameInfo*>(CGI)->mh->map = gs->map;
-		pathInfo = make_unique<CPathsInfo>(getMapSize());
+		pathCache.clear();
 		CGI->mh->init();
         logNetwork->infoStream() <<"Initing maphandler: "<<tmh.getDiff();
 	}
@@ -364,6 +394,7 @@ void CClient::loadGame(const std::string & fname, const bool server, const std::
 
 void CClient::newGame( CConnection *con, StartInfo *si )
 {
+	PROFILE_ZONE("CClient::newGame");
 	enum {SINGLE, HOST, GUEST} networkMode = SINGLE;
 
 	if (con == nullptr) 
@@ -428,7 +459,7 @@ void CClient::newGame( CConnection *con, StartInfo *si )
 		CGI->mh->map = gs->map;
         logNetwork->infoStream() <<"Creating mapHandler: "<<tmh.getDiff();
 		CGI->mh->init();
-		pathInfo = make_unique<CPathsInfo>(getMapSize());
+		pathCache.clear();
         logNetwork->infoStream() <<"Initializing mapHandler (together): "<<tmh.getDiff();
 	}
 
@@ -801,19 +832,151 @@ void CClient::commenceTacticPhaseForInt(shared_ptr<CBattleGameInterface> battleI
 void CClient::invalidatePaths()
 {
 	// turn pathfinding info into invalid. It will be regenerated later
-	boost::unique_lock<boost::mutex> pathLock(pathInfo->pathMx);
-	pathInfo->hero = nullptr;
+	boost::unique_lock<boost::mutex> cacheLock(pathCacheMx);
+	for(auto & cached : pathCache)
+	{
+		boost::unique_lock<boost::mutex> pathLock(cached.paths->pathMx);
+		cached.paths->hero = nullptr;
+	}
+	if(singlePaths)
+		singlePaths->hero = nullptr;
+}
+
+void CClient::invalidatePaths(const CGHeroInstance *moved, const int3 &start, const int3 &end, bool fowRevealed)
+{
+	const int3 tiles[] = {CGHeroInstance::convertPosition(start, false), CGHeroInstance::convertPosition(end, false)};
+
+	//other hero can be affected only by tiles that moved hero left or entered, and he can step on them only from a neighbouring tile
+	auto passesNearby = [&](const CPathsInfo &paths) -> bool
+	{
+		for(const int3 &tile : tiles)
+			for(int dx = -1; dx <= 1; dx++)
+				for(int dy = -1; dy <= 1; dy++)
+				{
+					const int3 pos = tile + int3(dx, dy, 0);
+					if(gs->map->isInTheMap(pos) && paths.getNode(pos).reachable())
+						return true;
+				}
+		return false;
+	};
+
+	boost::unique_lock<boost::mutex> cacheLock(pathCacheMx);
+	for(auto & cached : pathCache)
+	{
+		boost::unique_lock<boost::mutex> pathLock(cached.paths->pathMx);
+		const CGHeroInstance *h = cached.paths->hero;
+		if(!h)
+			continue;
+
+		//revealed tiles are shared by whole team, pathfinder uses team's fog of war
+		if(h == moved || (fowRevealed && getPlayerRelations(h->tempOwner, moved->tempOwner) != PlayerRelations::ENEMIES)
+			|| passesNearby(*cached.paths))
+		{
+			cached.paths->hero = nullptr;
+		}
+	}
+	if(singlePaths)
+		singlePaths->hero = nullptr;
+}
+
+CPathsInfo * CClient::getPathsBuffer(PlayerColor player, const CGHeroInstance *h, const std::vector<const CGHeroInstance *> &needed)
+{
+	auto isOwner = [player, h](const CachedPaths & cached)
+	{
+		return cached.player == player && cached.hero == h;
+	};
+	auto isFree = [player, &needed](const CachedPaths & cached)
+	{
+		return cached.player == player && !vstd::contains(needed, cached.hero);
+	};
+
+	auto it = boost::find_if(pathCache, isOwner);
+	if(it == pathCache.end())
+	{
+		const auto used = boost::count_if(pathCache, [player](const CachedPaths & cached){ return cached.player == player; });
+		if(used < GameConstants::MAX_HEROES_PER_PLAYER)
+		{
+			CachedPaths added;
+			added.player = player;
+			added.hero = h;
+			added.paths = make_unique<CPathsInfo>(getMapSize());
+			pathCache.push_back(std::move(added));
+			it = pathCache.end() - 1;
+		}
+		else
+		{
+			//take over buffer of least recently used hero of the same player, old paths there will be recalculated
+			it = boost::find_if(pathCache, isFree);
+			assert(it != pathCache.end());
+			it->hero = h;
+		}
+	}
+
+	std::rotate(it, it + 1, pathCache.end());
+	return pathCache.back().paths.get();
+}
+
+const CPathsInfo * CClient::getPathsInfo(PlayerColor player, const CGHeroInstance *h)
+{
+	assert(h);
+	boost::unique_lock<boost::mutex> cacheLock(pathCacheMx);
+	CPathsInfo *paths = getPathsBuffer(player, h, std::vector<const CGHeroInstance *>(1, h));
+	boost::unique_lock<boost::mutex> pathLock(paths->pathMx);
+	if (paths->hero != h)
+	{
+		gs->calculatePaths(h, *paths);
+	}
+	return paths;
+}
+
+const CPathsInfo * CClient::getPathsTo(PlayerColor player, const CGHeroInstance *h, const int3 &dst)
+{
+	for(auto & cached : pathCache)
+		if(cached.player == player && cached.hero == h && cached.paths->hero == h)
+			return cached.paths.get();
+
+	//single tile queries (hover, moving hero, AI heading to object) don't need paths to whole map
+	if(!singlePaths)
+		singlePaths = make_unique<CPathsInfo>(getMapSize());
+	if(singlePaths->hero != h || singlePlayer != player || singleDst != dst)
+	{
+		gs->calculatePaths(h, dst, *singlePaths);
+		singlePlayer = player;
+		singleDst = dst;
+	}
+	return singlePaths.get();
 }
 
-const CPathsInfo * CClient::getPathsInfo(const CGHeroInstance *h)
+bool CClient::getPath(PlayerColor player, const CGHeroInstance *h, const int3 &dst, CGPath &out)
 {
 	assert(h);
-	boost::unique_lock<boost::mutex> pathLock(pathInfo->pathMx);
-	if (pathInfo->hero != h)
+	boost::unique_lock<boost::mutex> cacheLock(pathCacheMx);
+	return getPathsTo(player, h, dst)->getPath(dst, out);
+}
+
+void CClient::calculatePaths(PlayerColor player, const std::vector<const CGHeroInstance *> &heroes)
+{
+	boost::unique_lock<boost::mutex> cacheLock(pathCacheMx);
+
+	//pathfinder only reads game state, so heroes may be processed in parallel as long as caller keeps state locked
+	std::vector<const CGHeroInstance *> needed(heroes.begin(), heroes.begin() + std::min<size_t>(heroes.size(), GameConstants::MAX_HEROES_PER_PLAYER));
+	std::vector<Task> tasks;
+	for(const CGHeroInstance *h : needed)
 	{
-		gs->calculatePaths(h, *pathInfo.get());
+		CPathsInfo *paths = getPathsBuffer(player, h, needed);
+		if(paths->hero == h)
+			continue;
+
+		tasks.push_back([this, h, paths]()
+		{
+			boost::unique_lock<boost::mutex> pathLock(paths->pathMx);
+			gs->calculatePaths(h, *paths);
+		});
 	}
-	return pathInfo.get();
+
+	int threads = std::min<int>(tasks.size(), std::max<int>(1, boost::thread::hardware_concurrency()));
+	CThreadHelper helper(&tasks, threads);
+	helper.run();
 }
 
 int CClient::sendRequest(const CPack *request, PlayerColor player)
@@ -960,18 +1123,21 @@ CConnection * CServerHandler::connectToServer()
 	return ret;
 }
 
+std::string CServerHandler::forcedPort;
+std::string CServerHandler::duelResultsFile;
+
 CServerHandler::CServerHandler(bool runServer /*= false*/)
 {
 	serverThread = nullptr;
 	shared = nullptr;
-	port = boost::lexical_cast<std::string>(settings["server"]["port"].Float());
+	port = forcedPort.size() ? forcedPort : boost::lexical_cast<std::string>(settings["server"]["port"].Float());
 	verbose = true;
 
 #ifndef VCMI_ANDROID
-	boost::interprocess::shared_memory_object::remove("vcmi_memory"); //if the application has previously crashed, the memory may not have been removed. to avoid problems - try to destroy it
+	boost::interprocess::shared_memory_object::remove(serverReadyMemoryName(port).c_str()); //if the application has previously crashed, the memory may not have been removed. to avoid problems - try to destroy it
 	try
 	{
-		shared = new SharedMem();
+		shared = new SharedMem(serverReadyMemoryName(port));
     }
     catch(...)
     {
@@ -991,8 +1157,13 @@ CServerHandler::~CServerHandler()
 void CServerHandler::callServer()
 {
 	setThreadName("CServerHandler::callServer");
-	const std::string logName = (VCMIDirs::get().userCachePath() / "server_log.txt").string();
-	const std::string comm = VCMIDirs::get().serverPath().string() + " --port=" + port + " > \"" + logName + '\"';
+	const std::string logName = (VCMIDirs::get().userCachePath() / (forcedPort.size() ? "server_log_" + port + ".txt" : "server_log.txt")).string();
+	std::string comm = VCMIDirs::get().serverPath().string() + " --port=" + port;
+	if(CProfiler::isEnabled())
+		comm += " --profile";
+	if(duelResultsFile.size())
+		comm += " --resultsFile=\"" + duelResultsFile + '\"';
+	comm += " > \"" + logName + '\"';
 	int result = std::system(comm.c_str());
 	if (result == 0)
         logNetwork->infoStream() << "Server closed correctly";
@@ -32,6 +32,8 @@ struct SharedMem;
 class CClient;
 class CScriptingModule;
 struct CPathsInfo;
+struct CGPath;
+struct CGPathNode;
 class CISer;
 class COSer;
 namespace boost { class thread; }
@@ -48,6 +50,9 @@ public:
 	bool verbose; //whether to print log msgs
 	std::string port; //port number in text form
 
+	static std::string forcedPort; //if not empty, used instead of port from settings (lets several local games run at once)
+	static std::string duelResultsFile; //if not empty, passed to started server as file for duel results
+
 	//functions setting up local server
 	void startServer(); //creates a thread with callServer
 	void waitForServer(); //waits till server is ready
@@ -115,7 +120,22 @@ public:
 /// Class which handles client - server logic
 class CClient : public IGameCallback
 {
-	unique_ptr<CPathsInfo> pathInfo;
+	struct CachedPaths
+	{
+		PlayerColor player; //local player who asked for paths, in hotseat every one has his own entries
+		const CGHeroInstance *hero;
+		unique_ptr<CPathsInfo> paths;
+	};
+
+	boost::mutex pathCacheMx;
+	std::vector<CachedPaths> pathCache; //buffers with paths of heroes recently asked by local players, least recently used first; buffers are reused, never freed during game
+
+	unique_ptr<CPathsInfo> singlePaths; //result of the last single destination search, guarded by pathCacheMx
+	PlayerColor singlePlayer;
+	int3 singleDst;
+
+	CPathsInfo * getPathsBuffer(PlayerColor player, const CGHeroInstance *h, const std::vector<const CGHeroInstance *> &needed); //needed -> heroes whose buffers must not be taken over
+	const CPathsInfo * getPathsTo(PlayerColor player, const CGHeroInstance *h, const int3 &dst); //cached paths of hero if there are any, otherwise searches only for dst; pathCacheMx must be locked
 public:
 	std::map<PlayerColor,shared_ptr<CCallback> > callbacks; //callbacks given to player interfaces
 	std::map<PlayerColor,shared_ptr<CBattleCallback> > battleCallbacks; //callbacks given to player interfaces
@@ -136,7 +156,12 @@ public:
 
 	ThreadSafeVector<int> waitingRequest;
 
+	boost::mutex decisionStatsMx;
+	ui32 battleDecisions; //number of activeStack calls answered by battle interfaces
+	si64 battleDecisionsTime; //total time spent in these calls, in microseconds
+
 	void waitForMoveAndSend(PlayerColor color);
+	void reportDuelStats(); //logs battle AI decision times, appends them to duel results file if one is used
 	//void sendRequest(const CPackForServer *request, bool waitForRealization);
 	CClient(void);
 	CClient(CConnection *con, StartInfo *si);
@@ -160,7 +185,10 @@ public:
 	void proposeNextMission(shared_ptr<CCampaignState> camp);
 
 	void invalidatePaths();
-	const CPathsInfo * getPathsInfo(const CGHeroInstance *h);
+	void invalidatePaths(const CGHeroInstance *moved, const int3 &start, const int3 &end, bool fowRevealed); //after hero move, drops only paths the move could change; start and end in h3m format
+	const CPathsInfo * getPathsInfo(PlayerColor player, const CGHeroInstance *h);
+	bool getPath(PlayerColor player, const CGHeroInstance *h, const int3 &dst, CGPath &out); //doesn't calculate whole map if paths of hero aren't cached
+	void calculatePaths(PlayerColor player, const std::vector<const CGHeroInstance *> &heroes); //fills paths cache of player for given heroes, each in its own thread
 
 	bool terminate;	// tell to terminate
 	boost::thread *connectionHandler; //thread running run() method
@@ -124,29 +124,23 @@ void Graphics::initializeBattleGraphics()
 }
 Graphics::Graphics()
 {
-	#if 0
+	//each task writes only its own members, SDL calls are serialised on CSDL_Ext::surfaceMx
+	//fonts are loaded later by main thread, SDL_ttf is not thread safe
+	CStopWatch timer;
 	std::vector<Task> tasks; //preparing list of graphics to load
-	tasks += std::bind(&Graphics::loadFonts,this);
 	tasks += std::bind(&Graphics::loadPaletteAndColors,this);
-	tasks += std::bind(&Graphics::loadHeroFlags,this);
+	loadHeroFlags(tasks);
+	loadHeroAnims(tasks);
 	tasks += std::bind(&Graphics::initializeBattleGraphics,this);
 	tasks += std::bind(&Graphics::loadErmuToPicture,this);
 	tasks += std::bind(&Graphics::initializeImageLists,this);
 	tasks += GET_DEF_ESS(resources32,"RESOURCE.DEF");	
 	tasks += GET_DEF_ESS(heroMoveArrows,"ADAG.DEF");
 
-	CThreadHelper th(&tasks,std::max((ui32)1,boost::thread::hardware_concurrency()));
-	th.run();
-	#else
-	loadFonts();
-	loadPaletteAndColors();
-	loadHeroFlags();
-	initializeBattleGraphics();
-	loadErmuToPicture();
-	initializeImageLists();
-	resources32 = CDefHandler::giveDefEss("RESOURCE.DEF");
-	heroMoveArrows = CDefHandler::giveDefEss("ADAG.DEF");
-	#endif
+	const ui32 threads = std::max((ui32)1,boost::thread::hardware_concurrency());
+	CThreadHelper loader(&tasks,threads);
+	loader.run();
+	logGlobal->infoStream() << boost::format("Loading %d graphics tasks in %d threads: %d ms") % tasks.size() % threads % timer.getDiff();
 
 	for(auto & elem : heroMoveArrows->ourImages)
 	{
@@ -154,7 +148,7 @@ Graphics::Graphics()
 	}
 }
 
-void Graphics::loadHeroAnims()
+void Graphics::loadHeroAnims(std::vector<Task> & tasks)
 {
 	//first - group number to be rotated1, second - group number after rotation1
 	std::vector<std::pair<int,int> > rotations = 
@@ -163,18 +157,28 @@ void Graphics::loadHeroAnims()
 		{2,14}, {3,15}
 	};
 
+	//entries are created first, so tasks only fill already existing elements
+	auto addTask = [&](CDefEssential * & destination, std::string name)
+	{
+		tasks.push_back([=, &destination]
+		{
+			destination = loadHeroAnim(name, rotations);
+		});
+	};
+
 	for(auto & elem : CGI->heroh->classes.heroClasses)
 	{
 		for (auto & templ : VLC->objtypeh->getHandlerFor(Obj::HERO, elem->id)->getTemplates())
 		{
 			if (!heroAnims.count(templ.animationFile))
-			heroAnims[templ.animationFile] = loadHeroAnim(templ.animationFile, rotations);
+				addTask(heroAnims[templ.animationFile], templ.animationFile);
 		}
 	}
 
-	boatAnims.push_back(loadHeroAnim("AB01_.DEF", rotations));
-	boatAnims.push_back(loadHeroAnim("AB02_.DEF", rotations));
-	boatAnims.push_back(loadHeroAnim("AB03_.DEF", rotations));
+	boatAnims.resize(3);
+	addTask(boatAnims[0], "AB01_.DEF");
+	addTask(boatAnims[1], "AB02_.DEF");
+	addTask(boatAnims[2], "AB03_.DEF");
 }
 
 CDefEssential * Graphics::loadHeroAnim( const std::string &name, const std::vector<std::pair<int,int> > &rotations)
@@ -263,6 +267,7 @@ void Graphics::loadHeroFlagsDetail(std::pair<std::vector<CDefEssential *> Graphi
 				}
 			}
 		}
+		boost::lock_guard<boost::mutex> lock(CSDL_Ext::surfaceMx);
 		for(auto & curImg : curImgs)
 		{
 			CSDL_Ext::setDefaultColorKey(curImg.bitmap);
@@ -273,9 +278,8 @@ void Graphics::loadHeroFlagsDetail(std::pair<std::vector<CDefEssential *> Graphi
 	}
 }
 
-void Graphics::loadHeroFlags()
+void Graphics::loadHeroFlags(std::vector<Task> & tasks)
 {
-	CStopWatch th;
 	std::pair<std::vector<CDefEssential *> Graphics::*, std::vector<const char *> > pr[4] =
 	{
 		{
@@ -301,20 +305,11 @@ void Graphics::loadHeroFlags()
 		}		
 	};
 
-	#if 0
-	boost::thread_group grupa;
 	for(int g=3; g>=0; --g)
 	{
-		grupa.create_thread(std::bind(&Graphics::loadHeroFlagsDetail, this, std::ref(pr[g]), true));
-	}
-	grupa.join_all();
-	#else
-	for(auto p: pr)
-	{
-		loadHeroFlagsDetail(p,true);
+		//pr is local, each task keeps its own copy
+		tasks.push_back(std::bind(&Graphics::loadHeroFlagsDetail, this, pr[g], true));
 	}
-	#endif
-    logGlobal->infoStream() << "Loading and transforming heroes' flags: "<<th.getDiff();
 }
 
 void Graphics::blueToPlayersAdv(SDL_Surface * sur, PlayerColor player)
@@ -71,9 +71,9 @@ public:
 	Graphics();	
 	void initializeBattleGraphics();
 	void loadPaletteAndColors();
-	void loadHeroFlags();
+	void loadHeroFlags(std::vector<std::function<void()> > & tasks);
 	void loadHeroFlagsDetail(std::pair<std::vector<CDefEssential *> Graphics::*, std::vector<const char *> > &pr, bool mode);
-	void loadHeroAnims();
+	void loadHeroAnims(std::vector<std::function<void()> > & tasks);
 	CDefEssential *  loadHeroAnim(const std::string &name, const std::vector<std::pair<int,int> > &rotations);
 	void loadErmuToPicture();
 	void blueToPlayersAdv(SDL_Surface * sur, PlayerColor player); //replaces blue interface colour with a color of player
@@ -377,7 +377,7 @@ void TryMoveHero::applyFirstCl( CClient *cl )
 void TryMoveHero::applyCl( CClient *cl )
 {
 	const CGHeroInstance *h = cl->getHero(id);
-	cl->invalidatePaths();
+	cl->invalidatePaths(h, start, end, !fowRevealed.empty());
 
 	if(result == TELEPORTATION  ||  result == EMBARK  ||  result == DISEMBARK)
 	{
@@ -724,6 +724,7 @@ void BattleResultsApplied::applyCl( CClient *cl )
 	INTERFACE_CALL_IF_PRESENT(PlayerColor::UNFLAGGABLE, battleResultsApplied);
 	if(GS(cl)->initialOpts->mode == StartInfo::DUEL)
 	{
+		cl->reportDuelStats();
 		handleQuit();
 	}
 }
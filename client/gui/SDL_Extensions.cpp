@@ -14,6 +14,8 @@ const SDL_Color Colors::METALLIC_GOLD = { 173, 142, 66, 0 };
 const SDL_Color Colors::GREEN = { 0, 255, 0, 0 };
 const SDL_Color Colors::DEFAULT_KEY_COLOR = {0, 255, 255, 0};
 
+boost::mutex CSDL_Ext::surfaceMx;
+
 #if (SDL_MAJOR_VERSION == 2)
 void SDL_UpdateRect(SDL_Surface *surface, int x, int y, int w, int h)
 {
@@ -81,7 +83,11 @@ void blitAt(SDL_Surface * src, const SDL_Rect & pos, SDL_Surface * dst)
 // Vertical flip
 SDL_Surface * CSDL_Ext::verticalFlip(SDL_Surface * toRot)
 {
-	SDL_Surface * ret = SDL_ConvertSurface(toRot, toRot->format, toRot->flags);
+	SDL_Surface * ret;
+	{
+		boost::lock_guard<boost::mutex> lock(surfaceMx);
+		ret = SDL_ConvertSurface(toRot, toRot->format, toRot->flags);
+	}
 	const int bpp = ret->format->BytesPerPixel;
 
 	char * src = reinterpret_cast<char *>(toRot->pixels);
@@ -115,7 +121,11 @@ SDL_Surface * CSDL_Ext::verticalFlip(SDL_Surface * toRot)
 // Horizontal flip
 SDL_Surface * CSDL_Ext::horizontalFlip(SDL_Surface * toRot)
 {
-	SDL_Surface * ret = SDL_ConvertSurface(toRot, toRot->format, toRot->flags);
+	SDL_Surface * ret;
+	{
+		boost::lock_guard<boost::mutex> lock(surfaceMx);
+		ret = SDL_ConvertSurface(toRot, toRot->format, toRot->flags);
+	}
 	char * src = reinterpret_cast<char *>(toRot->pixels);
 	char * dst = reinterpret_cast<char *>(ret->pixels) + ret->h * ret->pitch;
 
@@ -165,7 +175,8 @@ void CSDL_Ext::alphaTransform(SDL_Surface *src)
 	    {  0,   0,  0, 128}, {  0,   0,   0, 128}
 	};
 
-
+	//palette may be shared with other surfaces
+	boost::lock_guard<boost::mutex> lock(surfaceMx);
 	for (size_t i=0; i< ARRAY_COUNT(colors); i++ )
 	{
 		SDL_Color & palColor = src->format->palette->colors[i];
@@ -27,6 +27,7 @@
 #include "../lib/CGeneralTextHandler.h"
 #include "../lib/GameConstants.h"
 #include "../lib/CStopWatch.h"
+#include "../lib/CProfiler.h"
 #include "CMT.h"
 #include "../lib/CRandomGenerator.h"
 
@@ -378,6 +379,7 @@ void CMapHandler::initObjectRects()
 
 void CMapHandler::init()
 {
+	PROFILE_ZONE("CMapHandler::init");
 	CStopWatch th;
 	th.getDiff();
 
@@ -413,11 +415,17 @@ void CMapHandler::init()
 	offsetX = (mapW - (2*frameW+1)*32)/2;
 	offsetY = (mapH - (2*frameH+1)*32)/2;
 
-	prepareFOWDefs();
-	roadsRiverTerrainInit();	//road's and river's DefHandlers; and simple values initialization
-	borderAndTerrainBitmapInit();
+	{
+		PROFILE_ZONE("Preparing FoW, roads, rivers, borders");
+		prepareFOWDefs();
+		roadsRiverTerrainInit();	//road's and river's DefHandlers; and simple values initialization
+		borderAndTerrainBitmapInit();
+	}
 	logGlobal->infoStream()<<"\tPreparing FoW, roads, rivers,borders: "<<th.getDiff();
-	initObjectRects();
+	{
+		PROFILE_ZONE("Making object rects");
+		initObjectRects();
+	}
 	logGlobal->infoStream()<<"\tMaking object rects: "<<th.getDiff();
 
 }
@@ -44,20 +44,41 @@ BattleHex& BattleHex::moveInDir(EDir dir, bool hasToBeValid)
 	return *this;
 }
 
-std::vector<BattleHex> BattleHex::neighbouringTiles() const
+namespace
 {
-	std::vector<BattleHex> ret;
-	const int WN = GameConstants::BFIELD_WIDTH;
-	// H3 order : TR, R, BR, BL, L, TL (T = top, B = bottom ...)
+	//battlefield topology, built once when library is loaded as these are queried in innermost loops of pathfinding and AI
+	struct BattleHexTables
+	{
+		std::vector<BattleHex> neighbours[GameConstants::BFIELD_SIZE];
+		std::vector<BattleHex> noNeighbours; //for invalid hexes
+		char distances[GameConstants::BFIELD_SIZE][GameConstants::BFIELD_SIZE];
+
+		BattleHexTables()
+		{
+			const int WN = GameConstants::BFIELD_WIDTH;
+			for(si16 hex = 0; hex < GameConstants::BFIELD_SIZE; hex++)
+			{
+				std::vector<BattleHex> & ret = neighbours[hex];
+				// H3 order : TR, R, BR, BL, L, TL (T = top, B = bottom ...)
+				BattleHex::checkAndPush(hex - ( (hex/WN)%2 ? WN+1 : WN ), ret); // 1
+				BattleHex::checkAndPush(hex + 1, ret); // 2
+				BattleHex::checkAndPush(hex + ( (hex/WN)%2 ? WN : WN+1 ), ret); // 3
+				BattleHex::checkAndPush(hex + ( (hex/WN)%2 ? WN-1 : WN ), ret); // 4
+				BattleHex::checkAndPush(hex - 1, ret); // 5
+				BattleHex::checkAndPush(hex - ( (hex/WN)%2 ? WN : WN-1 ), ret); // 6
+
+				for(si16 other = 0; other < GameConstants::BFIELD_SIZE; other++)
+					distances[hex][other] = BattleHex::calculateDistance(hex, other);
+			}
+		}
+	};
 
-	checkAndPush(hex - ( (hex/WN)%2 ? WN+1 : WN ), ret); // 1
-	checkAndPush(hex + 1, ret); // 2
-	checkAndPush(hex + ( (hex/WN)%2 ? WN : WN+1 ), ret); // 3
-	checkAndPush(hex + ( (hex/WN)%2 ? WN-1 : WN ), ret); // 4
-	checkAndPush(hex - 1, ret); // 5
-	checkAndPush(hex - ( (hex/WN)%2 ? WN : WN-1 ), ret); // 6
+	const BattleHexTables hexTables;
+}
 
-	return ret;
+const std::vector<BattleHex> & BattleHex::neighbouringTiles() const
+{
+	return isValid() ? hexTables.neighbours[hex] : hexTables.noNeighbours;
 }
 
 signed char BattleHex::mutualPosition(BattleHex hex1, BattleHex hex2)
@@ -78,6 +99,13 @@ signed char BattleHex::mutualPosition(BattleHex hex1, BattleHex hex2)
 }
 
 char BattleHex::getDistance(BattleHex hex1, BattleHex hex2)
+{
+	if(hex1.isValid() && hex2.isValid())
+		return hexTables.distances[hex1][hex2];
+	return calculateDistance(hex1, hex2);
+}
+
+char BattleHex::calculateDistance(BattleHex hex1, BattleHex hex2)
 {	
 	int y1 = hex1.getY(), 
 		y2 = hex2.getY();
@@ -95,6 +123,21 @@ char BattleHex::getDistance(BattleHex hex1, BattleHex hex2)
 	return std::abs(xDst) + std::abs(yDst);
 }
 
+std::vector<BattleHex> BattleHex::getInRange(BattleHex center, int low, int high)
+{
+	std::vector<BattleHex> ret;
+	if(!center.isValid())
+		return ret;
+
+	for(si16 hex = 0; hex < GameConstants::BFIELD_SIZE; hex++)
+	{
+		const int distance = hexTables.distances[center][hex];
+		if(distance >= low && distance <= high)
+			ret.push_back(hex);
+	}
+	return ret;
+}
+
 void BattleHex::checkAndPush(BattleHex tile, std::vector<BattleHex> & ret)
 {
 	if(tile.isAvailable())
@@ -13,6 +13,8 @@
  *
  */
 
+typedef std::bitset<GameConstants::BFIELD_SIZE> TBattleHexMask; //one bit per battlefield hex
+
 // for battle stacks' positions
 struct DLL_LINKAGE BattleHex
 {
@@ -83,13 +85,17 @@ struct DLL_LINKAGE BattleHex
 	}
 	BattleHex operator+(EDir dir) const { return movedInDir(dir); }
 
-	std::vector<BattleHex> neighbouringTiles() const;
+	//available neighbours in H3 order, taken from precomputed table (empty for invalid hex)
+	const std::vector<BattleHex> & neighbouringTiles() const;
 
 	//returns info about mutual position of given hexes (-1 - they're distant, 0 - left top, 1 - right top, 2 - right, 3 - right bottom, 4 - left bottom, 5 - left)
 	static signed char mutualPosition(BattleHex hex1, BattleHex hex2);
 
-	//returns distance between given hexes
+	//returns distance between given hexes, taken from precomputed table if both are valid
 	static char getDistance(BattleHex hex1, BattleHex hex2);
+	static char calculateDistance(BattleHex hex1, BattleHex hex2);
+	//returns battlefield hexes in distance between low and high from center, in increasing order
+	static std::vector<BattleHex> getInRange(BattleHex center, int low, int high);
 
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
@@ -749,6 +749,33 @@ BattleInfo::BattleInfo()
 {
 	setBattle(this);
 	setNodeType(BATTLE);
+	stateVersion = 0;
+}
+
+bool BattleInfo::getCachedReachability(const TReachabilityKey & key, ReachabilityInfo & out, ui32 & version) const
+{
+	boost::unique_lock<boost::mutex> lock(reachabilityMx);
+	version = stateVersion;
+	auto it = reachabilityCache.find(key);
+	if(it == reachabilityCache.end())
+		return false;
+
+	out = it->second;
+	return true;
+}
+
+void BattleInfo::cacheReachability(const TReachabilityKey & key, const ReachabilityInfo & info, ui32 version) const
+{
+	boost::unique_lock<boost::mutex> lock(reachabilityMx);
+	if(version == stateVersion) //otherwise it was calculated for state that is already gone
+		reachabilityCache[key] = info;
+}
+
+void BattleInfo::stateChanged()
+{
+	boost::unique_lock<boost::mutex> lock(reachabilityMx);
+	stateVersion++;
+	reachabilityCache.clear();
 }
 
 CArmedInstance * BattleInfo::battleGetArmyObject(ui8 side) const
@@ -95,6 +95,10 @@ struct DLL_LINKAGE BattleInfo : public CBonusSystemNode, public CBattleInfoCallb
 	ui8 tacticsSide; //which side is requested to play tactics phase
 	ui8 tacticDistance; //how many hexes we can go forward (1 = only hexes adjacent to margin line)
 
+	mutable boost::mutex reachabilityMx;
+	mutable ui32 stateVersion; //increased whenever battle state changes, invalidates memoised reachability
+	mutable std::map<TReachabilityKey, ReachabilityInfo> reachabilityCache;
+
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
 		h & sides;
@@ -108,6 +112,11 @@ struct DLL_LINKAGE BattleInfo : public CBonusSystemNode, public CBattleInfoCallb
 	BattleInfo();
 	~BattleInfo(){};
 
+	//memoised reachability, shared by all callbacks looking at this battle
+	bool getCachedReachability(const TReachabilityKey & key, ReachabilityInfo & out, ui32 & version) const; //version is set to the one result has to be stored for
+	void cacheReachability(const TReachabilityKey & key, const ReachabilityInfo & info, ui32 version) const; //ignored if state changed since version was taken
+	void stateChanged(); //to be called after every change of battle state
+
 	//////////////////////////////////////////////////////////////////////////
 	CStack * getStackT(BattleHex tileID, bool onlyAlive = true);
 	CStack * getStack(int stackID, bool onlyAlive = true);
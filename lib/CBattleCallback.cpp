@@ -231,6 +231,16 @@ const CGTownInstance * CBattleInfoEssentials::battleGetDefendedTown() const
 	return getBattle()->town;
 }
 
+bool CBattleInfoEssentials::battleGetCachedReachability(const TReachabilityKey & key, ReachabilityInfo & out, ui32 & version) const
+{
+	return getBattle()->getCachedReachability(key, out, version);
+}
+
+void CBattleInfoEssentials::battleCacheReachability(const TReachabilityKey & key, const ReachabilityInfo & info, ui32 version) const
+{
+	getBattle()->cacheReachability(key, info, version);
+}
+
 BattlePerspective::BattlePerspective CBattleInfoEssentials::battleGetMySide() const
 {
 	RETURN_IF_NOT_BATTLE(BattlePerspective::INVALID);
@@ -1158,6 +1168,18 @@ AccessibilityInfo CBattleInfoCallback::getAccesibility(const std::vector<BattleH
 }
 
 ReachabilityInfo CBattleInfoCallback::makeBFS(const AccessibilityInfo &accessibility, const ReachabilityInfo::Parameters &params) const
+{
+	TBattleHexMask quicksands;
+	if(params.startPosition.isValid()) //no obstacles lookup for arrow turrets
+	{
+		for(BattleHex hex : getStoppers(params.perspective))
+			if(hex.isValid())
+				quicksands.set(hex);
+	}
+	return makeBFS(accessibility, params, quicksands);
+}
+
+ReachabilityInfo CBattleInfoCallback::makeBFS(const AccessibilityInfo &accessibility, const ReachabilityInfo::Parameters &params, const TBattleHexMask &quicksands)
 {
 	ReachabilityInfo ret;
 	ret.accessibility = accessibility;
@@ -1169,35 +1191,31 @@ ReachabilityInfo CBattleInfoCallback::makeBFS(const AccessibilityInfo &accessibi
 	if(!params.startPosition.isValid()) //if got call for arrow turrets
 		return ret;
 
-	const std::set<BattleHex> quicksands = getStoppers(params.perspective);
-	//const bool twoHexCreature = params.doubleWide;
-
+	//each hex is queued at most once, so checking one bit replaces both accessibility and distance checks
+	TBattleHexMask unvisited = accessibility.accessibleMask(params.doubleWide, params.attackerOwned);
+	unvisited.reset(params.startPosition);
 
-	std::queue<BattleHex> hexq; //bfs queue
-
-	//first element
-	hexq.push(params.startPosition);
+	std::array<BattleHex, GameConstants::BFIELD_SIZE> hexq;
+	int first = 0, last = 0;
+	hexq[last++] = params.startPosition;
 	ret.distances[params.startPosition] = 0;
 
-	while(!hexq.empty()) //bfs loop
+	while(first < last)
 	{
-		const BattleHex curHex = hexq.front();
-		hexq.pop();
+		const BattleHex curHex = hexq[first++];
 
 		//walking stack can't step past the quicksands
 		//TODO what if second hex of two-hex creature enters quicksand
-		if(curHex != params.startPosition && vstd::contains(quicksands, curHex))
+		if(curHex != params.startPosition && quicksands[curHex])
 			continue;
 
 		const int costToNeighbour = ret.distances[curHex] + 1;
 		for(BattleHex neighbour : curHex.neighbouringTiles())
 		{
-			const bool accessible = accessibility.accessible(neighbour, params.doubleWide, params.attackerOwned);
-			const int costFoundSoFar = ret.distances[neighbour];
-
-			if(accessible  &&  costToNeighbour < costFoundSoFar)
+			if(unvisited[neighbour])
 			{
-				hexq.push(neighbour);
+				unvisited.reset(neighbour);
+				hexq[last++] = neighbour;
 				ret.distances[neighbour] = costToNeighbour;
 				ret.predecessors[neighbour] = curHex;
 			}
@@ -1303,10 +1321,24 @@ ReachabilityInfo CBattleInfoCallback::getReachability(const CStack *stack) const
 
 ReachabilityInfo CBattleInfoCallback::getReachability(const ReachabilityInfo::Parameters &params) const
 {
+	//visible obstacles depend also on side we are looking from
+	const auto key = std::make_pair(battleGetMySide(), params);
+
+	ReachabilityInfo ret;
+	ui32 version;
+	if(battleGetCachedReachability(key, ret, version))
+	{
+		ret.params = params;
+		return ret;
+	}
+
 	if(params.flying)
-		return getFlyingReachability(params);
+		ret = getFlyingReachability(params);
 	else
-		return makeBFS(getAccesibility(params.knownAccessible), params);
+		ret = makeBFS(getAccesibility(params.knownAccessible), params);
+
+	battleCacheReachability(key, ret, version);
+	return ret;
 }
 
 ReachabilityInfo CBattleInfoCallback::getFlyingReachability(const ReachabilityInfo::Parameters &params) const
@@ -2086,19 +2118,31 @@ bool AccessibilityInfo::accessible(BattleHex tile, const CStack *stack) const
 
 bool AccessibilityInfo::accessible(BattleHex tile, bool doubleWide, bool attackerOwned) const
 {
-	// All hexes that stack would cover if standing on tile have to be accessible.
-	for(auto hex : CStack::getHexes(tile, doubleWide, attackerOwned))
+	auto hexAccessible = [&](BattleHex hex)
 	{
-        // If the hex is out of range then the tile isn't accessible
-        if(!hex.isValid())
-            return false;
-        // If we're no defender which step on gate and the hex isn't accessible, then the tile
-        // isn't accessible
-        else if(at(hex) != EAccessibility::ACCESSIBLE &&
-                !(at(hex) == EAccessibility::GATE && !attackerOwned))
-            return false;
-	}
-	return true;
+		// If the hex is out of range then the tile isn't accessible
+		if(!hex.isValid())
+			return false;
+		// If we're no defender which step on gate and the hex isn't accessible, then the tile
+		// isn't accessible
+		return at(hex) == EAccessibility::ACCESSIBLE || (at(hex) == EAccessibility::GATE && !attackerOwned);
+	};
+
+	// All hexes that stack would cover if standing on tile have to be accessible (same hexes as CStack::getHexes, without allocating them).
+	return hexAccessible(tile) && (!doubleWide || hexAccessible(attackerOwned ? tile - 1 : tile + 1));
+}
+
+TBattleHexMask AccessibilityInfo::accessibleMask(bool doubleWide, bool attackerOwned) const
+{
+	TBattleHexMask ret;
+	for(int hex = 0; hex < GameConstants::BFIELD_SIZE; hex++)
+		ret[hex] = at(hex) == EAccessibility::ACCESSIBLE || (at(hex) == EAccessibility::GATE && !attackerOwned);
+
+	//second hex of double wide stack is behind the tile it stands on
+	if(doubleWide)
+		ret &= attackerOwned ? (ret << 1) : (ret >> 1);
+
+	return ret;
 }
 
 bool AccessibilityInfo::occupiable(const CStack *stack, BattleHex tile) const
@@ -2136,6 +2180,12 @@ ReachabilityInfo::Parameters::Parameters(const CStack *Stack)
 	knownAccessible = stack->getHexes();
 }
 
+bool ReachabilityInfo::Parameters::operator<(const Parameters & other) const
+{
+	return std::tie(startPosition, perspective, attackerOwned, doubleWide, flying, knownAccessible)
+		< std::tie(other.startPosition, other.perspective, other.attackerOwned, other.doubleWide, other.flying, other.knownAccessible);
+}
+
 ESpellCastProblem::ESpellCastProblem CPlayerBattleCallback::battleCanCastThisSpell(const CSpell * spell) const
 {
 	RETURN_IF_NOT_BATTLE(ESpellCastProblem::INVALID);
@@ -99,6 +99,7 @@ struct DLL_LINKAGE AccessibilityInfo : TAccessibilityArray
 	bool occupiable(const CStack *stack, BattleHex tile) const;
 	bool accessible(BattleHex tile, const CStack *stack) const; //checks for both tiles if stack is double wide
 	bool accessible(BattleHex tile, bool doubleWide, bool attackerOwned) const; //checks for both tiles if stack is double wide
+	TBattleHexMask accessibleMask(bool doubleWide, bool attackerOwned) const; //all tiles for which accessible() is true
 };
 
 namespace BattlePerspective
@@ -135,6 +136,8 @@ struct DLL_LINKAGE ReachabilityInfo
 
 		Parameters();
 		Parameters(const CStack *Stack);
+
+		bool operator<(const Parameters & other) const; //compares everything but stack, which does not affect result
 	};
 
 	Parameters params;
@@ -154,10 +157,15 @@ struct DLL_LINKAGE ReachabilityInfo
 	}
 };
 
+typedef std::pair<BattlePerspective::BattlePerspective, ReachabilityInfo::Parameters> TReachabilityKey; //perspective of asking callback and BFS parameters
+
 class DLL_LINKAGE CBattleInfoEssentials : public virtual CCallbackBase
 {
 protected:
 	bool battleDoWeKnowAbout(ui8 side) const;
+	//memoised reachability stored in battle, see BattleInfo
+	bool battleGetCachedReachability(const TReachabilityKey & key, ReachabilityInfo & out, ui32 & version) const;
+	void battleCacheReachability(const TReachabilityKey & key, const ReachabilityInfo & info, ui32 version) const;
 public:
 	enum EStackOwnership
 	{
@@ -310,6 +318,7 @@ public:
 	AccessibilityInfo getAccesibility(const CStack *stack) const; //Hexes ocupied by stack will be marked as accessible.
 	AccessibilityInfo getAccesibility(const std::vector<BattleHex> &accessibleHexes) const; //given hexes will be marked as accessible
 	std::pair<const CStack *, BattleHex> getNearestStack(const CStack * closest, boost::logic::tribool attackerOwned) const;
+	static ReachabilityInfo makeBFS(const AccessibilityInfo &accessibility, const ReachabilityInfo::Parameters &params, const TBattleHexMask &quicksands); //doesn't need battle, walking stack stops on quicksands
 protected:
 	ReachabilityInfo getFlyingReachability(const ReachabilityInfo::Parameters &params) const;
 	ReachabilityInfo makeBFS(const AccessibilityInfo &accessibility, const ReachabilityInfo::Parameters &params) const;
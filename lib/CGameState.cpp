@@ -26,6 +26,7 @@
 #include "GameConstants.h"
 #include "rmg/CMapGenerator.h"
 #include "CStopWatch.h"
+#include "CProfiler.h"
 #include "mapping/CMapEditManager.h"
 
 class CGObjectInstance;
@@ -746,6 +747,7 @@ BattleInfo * CGameState::setupBattle(int3 tile, const CArmedInstance *armies[2],
 
 void CGameState::init(StartInfo * si)
 {
+	PROFILE_ZONE("CGameState::init");
     logGlobal->infoStream() << "\tUsing random seed: "<< si->seedToBeUsed;
 	rand.setSeed(si->seedToBeUsed);
 	scenarioOps = CMemorySerializer::deepCopy(*si).release();
@@ -2099,7 +2101,7 @@ void CGameState::getNeighbours(const TerrainTile &srct, int3 tile, std::vector<i
 	}
 }
 
-int CGameState::getMovementCost(const CGHeroInstance *h, const int3 &src, const int3 &dest, bool flying, int remainingMovePoints, bool checkLast)
+int CGameState::getMovementCost(const CGHeroInstance *h, const int3 &src, const int3 &dest, bool flying, int remainingMovePoints, bool checkLast, const HeroMovementInfo *info)
 {
 	if(src == dest) //same tile
 		return 0;
@@ -2108,11 +2110,11 @@ int CGameState::getMovementCost(const CGHeroInstance *h, const int3 &src, const
 		&d = map->getTile(dest);
 
 	//get basic cost
-	int ret = h->getTileCost(d,s);
+	int ret = h->getTileCost(d, s, info);
 
 	if(d.blocked && flying)
 	{
-		bool freeFlying = h->getBonusesCount(Selector::typeSubtype(Bonus::FLYING_MOVEMENT, 1)) > 0;
+		bool freeFlying = info ? info->freeFlying : h->getBonusesCount(Selector::typeSubtype(Bonus::FLYING_MOVEMENT, 1)) > 0;
 
 		if(!freeFlying)
 		{
@@ -2123,7 +2125,7 @@ int CGameState::getMovementCost(const CGHeroInstance *h, const int3 &src, const
 	{
 		if(h->boat && s.hasFavourableWinds() && d.hasFavourableWinds()) //Favourable Winds
 			ret *= 0.666;
-		else if (!h->boat && h->getBonusesCount(Selector::typeSubtype(Bonus::WATER_WALKING, 1)) > 0)
+		else if (info ? info->waterWalkingPenalty : !h->boat && h->getBonusesCount(Selector::typeSubtype(Bonus::WATER_WALKING, 1)) > 0)
 			ret *= 1.4; //40% penalty for water walking
 	}
 
@@ -2147,7 +2149,7 @@ int CGameState::getMovementCost(const CGHeroInstance *h, const int3 &src, const
         getNeighbours(d, dest, vec, s.terType != ETerrainType::WATER, true);
 		for(auto & elem : vec)
 		{
-			int fcost = getMovementCost(h,dest, elem, flying, left, false);
+			int fcost = getMovementCost(h,dest, elem, flying, left, false, info);
 			if(fcost <= left)
 			{
 				return ret;
@@ -2162,6 +2164,8 @@ void CGameState::apply(CPack *pack)
 {
 	ui16 typ = typeList.getTypeID(pack);
 	applierGs->apps[typ]->applyOnGS(this,pack);
+	if(curB)
+		curB->stateChanged(); //any pack may move, kill or add stacks, obstacles or walls
 }
 
 void CGameState::calculatePaths(const CGHeroInstance *hero, CPathsInfo &out)
@@ -2170,6 +2174,12 @@ void CGameState::calculatePaths(const CGHeroInstance *hero, CPathsInfo &out)
 	pathfinder.calculatePaths();
 }
 
+void CGameState::calculatePaths(const CGHeroInstance *hero, const int3 &dst, CPathsInfo &out)
+{
+	CPathfinder pathfinder(out, this, hero);
+	pathfinder.calculatePaths(dst);
+}
+
 /**
  * Tells if the tile is guarded by a monster as well as the position
  * of the monster that will attack on it.
@@ -2899,13 +2909,28 @@ bool CGPathNode::reachable() const
 	return turns < 255;
 }
 
+HeroMovementInfo::HeroMovementInfo(const CGHeroInstance *h)
+{
+	//without road cost depends only on terrain of tile hero leaves
+	TerrainTile tile;
+	tile.roadType = ERoadType::NO_ROAD;
+	for(int i = 0; i < GameConstants::TERRAIN_TYPES; i++)
+	{
+		tile.terType = ETerrainType(static_cast<ETerrainType::EETerrainType>(i));
+		terrainCost[i] = h->getTileCost(tile, tile);
+	}
+
+	freeFlying = h->getBonusesCount(Selector::typeSubtype(Bonus::FLYING_MOVEMENT, 1)) > 0;
+	waterWalkingPenalty = !h->boat && h->getBonusesCount(Selector::typeSubtype(Bonus::WATER_WALKING, 1)) > 0;
+}
+
 const CGPathNode * CPathsInfo::getPathInfo( int3 tile ) const
 {
 	boost::unique_lock<boost::mutex> pathLock(pathMx);
 
 	if (tile.x >= sizes.x || tile.y >= sizes.y || tile.z >= sizes.z)
 		return nullptr;
-	return &nodes[tile.x][tile.y][tile.z];
+	return &getNode(tile);
 }
 
 int CPathsInfo::getDistance( int3 tile ) const
@@ -2924,7 +2949,7 @@ bool CPathsInfo::getPath( const int3 &dst, CGPath &out ) const
 	boost::unique_lock<boost::mutex> pathLock(pathMx);
 
 	out.nodes.clear();
-	const CGPathNode *curnode = &nodes[dst.x][dst.y][dst.z];
+	const CGPathNode *curnode = &getNode(dst);
 	if(!curnode->theNodeBefore)
 		return false;
 
@@ -2939,31 +2964,13 @@ bool CPathsInfo::getPath( const int3 &dst, CGPath &out ) const
 }
 
 CPathsInfo::CPathsInfo( const int3 &Sizes )
-:sizes(Sizes)
+:sizes(Sizes), nodes(Sizes.x * Sizes.y * Sizes.z)
 {
 	hero = nullptr;
-	nodes = new CGPathNode**[sizes.x];
 	for(int i = 0; i < sizes.x; i++)
-	{
-		nodes[i] = new CGPathNode*[sizes.y];
 		for (int j = 0; j < sizes.y; j++)
-		{
-			nodes[i][j] = new CGPathNode[sizes.z];
-		}
-	}
-}
-
-CPathsInfo::~CPathsInfo()
-{
-	for(int i = 0; i < sizes.x; i++)
-	{
-		for (int j = 0; j < sizes.y; j++)
-		{
-			delete [] nodes[i][j];
-		}
-		delete [] nodes[i];
-	}
-	delete [] nodes;
+			for (int k = 0; k < sizes.z; k++)
+				getNode(int3(i, j, k)).coord = int3(i, j, k);
 }
 
 int3 CGPath::startPos() const
@@ -3276,31 +3283,86 @@ TeamState::TeamState()
 
 void CPathfinder::initializeGraph()
 {
-	CGPathNode ***graph = out.nodes;
-	for(size_t i=0; i < out.sizes.x; ++i)
+	tileObjects.resize(out.nodes.size());
+
+	//nodes are stored in the same order as we visit them here, so this is a single linear pass over the buffer
+	for(CGPathNode &node : out.nodes)
 	{
-		for(size_t j=0; j < out.sizes.y; ++j)
-		{
-			for(size_t k=0; k < out.sizes.z; ++k)
-			{
-				curPos = int3(i,j,k);
-				const TerrainTile *tinfo = &gs->map->getTile(int3(i, j, k));
-				CGPathNode &node = graph[i][j][k];
+		curPos = node.coord;
+		const TerrainTile *tinfo = &gs->map->getTile(curPos);
 
-				node.accessible = evaluateAccessibility(tinfo);
-				node.turns = 0xff;
-				node.moveRemains = 0;
-				node.coord.x = i;
-				node.coord.y = j;
-				node.coord.z = k;
-                node.land = tinfo->terType != ETerrainType::WATER;
-				node.theNodeBefore = nullptr;
-			}
-		}
+		TileObjects &objects = tileObjects[&node - out.nodes.data()];
+		objects.top = tinfo->topVisitableObj();
+		objects.teleport = dynamic_cast<const CGTeleport *>(objects.top);
+
+		node.accessible = evaluateAccessibility(tinfo);
+		node.turns = 0xff;
+		node.moveRemains = 0;
+		node.land = tinfo->terType != ETerrainType::WATER;
+		node.theNodeBefore = nullptr;
 	}
 }
 
 void CPathfinder::calculatePaths()
+{
+	search(int3(-1, -1, -1));
+}
+
+void CPathfinder::calculatePaths(const int3 &dst)
+{
+	search(dst);
+}
+
+/// (turnsA, movesA) lets hero reach tile sooner than (turnsB, movesB)
+static bool isBetterLabel(ui8 turnsA, ui32 movesA, ui8 turnsB, ui32 movesB)
+{
+	return turnsA < turnsB || (turnsA == turnsB && movesA > movesB);
+}
+
+bool CPathfinder::QueueEntry::operator<(const QueueEntry &other) const
+{
+	return isBetterLabel(other.turns, other.moveRemains, turns, moveRemains);
+}
+
+void CPathfinder::pushNode(CGPathNode *node)
+{
+	if(order == FIFO)
+	{
+		mq.push_back(node);
+		return;
+	}
+
+	QueueEntry entry;
+	entry.turns = node->turns;
+	entry.moveRemains = node->moveRemains;
+	entry.node = node;
+	pq.push(entry);
+}
+
+CGPathNode *CPathfinder::popNode()
+{
+	if(order == FIFO)
+	{
+		if(mq.empty())
+			return nullptr;
+
+		CGPathNode *node = mq.front();
+		mq.pop_front();
+		return node;
+	}
+
+	while(!pq.empty())
+	{
+		QueueEntry entry = pq.top();
+		pq.pop();
+		//node got better label after this entry was queued -> there is another entry for it
+		if(entry.turns == entry.node->turns && entry.moveRemains == entry.node->moveRemains)
+			return entry.node;
+	}
+	return nullptr;
+}
+
+void CPathfinder::search(const int3 &dst)
 {
 	bool flying = hero->hasBonusOfType(Bonus::FLYING_MOVEMENT);
 	int maxMovePointsLand = hero->maxMovePoints(true);
@@ -3324,18 +3386,25 @@ void CPathfinder::calculatePaths()
 	//logGlobal->infoStream() << boost::format("Calculating paths for hero %s (adress  %d) of player %d") % hero->name % hero % hero->tempOwner;
 	initializeGraph();
 
+	//Nodes leave priority queue in order of their labels and moving never gives hero more movement points than he had,
+	//so once the best queued label is not better than destination's one nothing can improve destination anymore.
+	//Free ship boarding breaks that (disembarking can scale movement points up), so whole map is calculated then.
+	CGPathNode *goal = nullptr;
+	if(order == PRIORITY && gs->map->isInTheMap(dst) && !hero->hasBonusOfType(Bonus::FREE_SHIP_BOARDING))
+		goal = getNode(dst);
+
 	//initial tile - set cost on 0 and add to the queue
 	CGPathNode &initialNode = *getNode(out.hpos);
 	initialNode.turns = 0;
 	initialNode.moveRemains = hero->movement;
-	mq.push_back(&initialNode);
+	pushNode(&initialNode);
 
 	std::vector<int3> neighbours;
 	neighbours.reserve(16);
-	while(!mq.empty())
+	while((cp = popNode()))
 	{
-		cp = mq.front();
-		mq.pop_front();
+		if(goal && goal->turns != 0xff && !isBetterLabel(cp->turns, cp->moveRemains, goal->turns, goal->moveRemains))
+			break;
 
 		const int3 sourceGuardPosition = gs->map->guardingCreaturePositions[cp->coord.x][cp->coord.y][cp->coord.z];
 		bool guardedSource = (sourceGuardPosition != int3(-1, -1, -1) && cp->coord != src);
@@ -3368,8 +3437,13 @@ void CPathfinder::calculatePaths()
 			return false;
 		};
 
-		auto sObj = ct->topVisitableObj(cp->coord == CGHeroInstance::convertPosition(hero->pos, false));
-		auto cObj = dynamic_cast<const CGTeleport *>(sObj);
+		const CGObjectInstance *sObj = getObjects(cp).top;
+		const CGTeleport *cObj = getObjects(cp).teleport;
+		if(cp->coord == src) //hero is not an obstacle on his own tile
+		{
+			sObj = ct->topVisitableObj(true);
+			cObj = dynamic_cast<const CGTeleport *>(sObj);
+		}
 		if(isAllowedTeleportEntrance(cObj))
 		{
 			for(auto objId : gs->getTeleportChannelExits(cObj->channel, hero->tempOwner))
@@ -3380,30 +3454,31 @@ void CPathfinder::calculatePaths()
 			}
 		}
 
-		std::vector<int3> neighbour_tiles;
-		gs->getNeighbours(*ct, cp->coord, neighbour_tiles, boost::logic::indeterminate, !cp->land);
+		neighbourTiles.clear();
+		gs->getNeighbours(*ct, cp->coord, neighbourTiles, boost::logic::indeterminate, !cp->land);
 		if(sObj)
 		{
-			for(int3 neighbour_tile: neighbour_tiles)
+			for(int3 neighbour_tile: neighbourTiles)
 			{
 				if(canMoveBetween(neighbour_tile, sObj->visitablePos()))
 					neighbours.push_back(neighbour_tile);
 			}
 		}
 		else
-			vstd::concatenate(neighbours, neighbour_tiles);
+			vstd::concatenate(neighbours, neighbourTiles);
 
 		for(auto & neighbour : neighbours)
 		{
 			const int3 &n = neighbour; //current neighbor
 			dp = getNode(n);
 			dt = &gs->map->getTile(n);
-			destTopVisObjID = dt->topVisitableId();
+			const TileObjects &dstObjects = getObjects(dp);
+			destTopVisObjID = dstObjects.top ? dstObjects.top->ID : Obj(Obj::NO_OBJ);
 
 			useEmbarkCost = 0; //0 - usual movement; 1 - embark; 2 - disembark
 			const bool destIsGuardian = sourceGuardPosition == n;
 
-			auto dObj = dynamic_cast<const CGTeleport*>(dt->topVisitableObj());
+			const CGTeleport *dObj = dstObjects.teleport;
 			if(!goodForLandSeaTransition()
 			   || (!canMoveBetween(cp->coord, dp->coord) && !CGTeleport::isConnected(cObj, dObj))
 			   || dp->accessible == CGPathNode::BLOCKED)
@@ -3412,10 +3487,10 @@ void CPathfinder::calculatePaths()
 			}
 
 			//special case -> hero embarked a boat standing on a guarded tile -> we must allow to move away from that tile
-			if(cp->accessible == CGPathNode::VISITABLE && guardedSource && cp->theNodeBefore->land && ct->topVisitableId() == Obj::BOAT)
+			if(cp->accessible == CGPathNode::VISITABLE && guardedSource && cp->theNodeBefore->land && getObjects(cp).top && getObjects(cp).top->ID == Obj::BOAT)
 				guardedSource = false;
 
-			int cost = gs->getMovementCost(hero, cp->coord, dp->coord, flying, movement);
+			int cost = gs->getMovementCost(hero, cp->coord, dp->coord, flying, movement, true, &movementInfo);
 			//special case -> moving from src Subterranean gate to dest gate -> it's free
 			if(CGTeleport::isConnected(cObj, dObj))
 				cost = 0;
@@ -3433,7 +3508,7 @@ void CPathfinder::calculatePaths()
 				//occurs rarely, when hero with low movepoints tries to leave the road
 				turnAtNextTile++;
 				int moveAtNextTile = maxMovePoints(cp);
-				cost = gs->getMovementCost(hero, cp->coord, dp->coord, flying, moveAtNextTile); //cost must be updated, movement points changed :(
+				cost = gs->getMovementCost(hero, cp->coord, dp->coord, flying, moveAtNextTile, true, &movementInfo); //cost must be updated, movement points changed :(
 				remains = moveAtNextTile - cost;
 			}
 
@@ -3456,7 +3531,7 @@ void CPathfinder::calculatePaths()
 						return true;
 					if(dp->coord == CGHeroInstance::convertPosition(hero->pos, false))
 						return true; // This one is tricky, we can ignore fact that tile is not ACCESSIBLE in case if it's our hero block it. Though this need investigation
-					if(dp->accessible == CGPathNode::VISITABLE && CGTeleport::isTeleport(dt->topVisitableObj()))
+					if(dp->accessible == CGPathNode::VISITABLE && dObj)
 						return true; // For now we'll walways allos transit for teleports
 					if(useEmbarkCost && allowEmbarkAndDisembark)
 						return true;
@@ -3471,15 +3546,24 @@ void CPathfinder::calculatePaths()
 				};
 
 				if(checkDestinationTile())
-					mq.push_back(dp);
+					pushNode(dp);
 			}
 		} //neighbours loop
 	} //queue loop
+
+	//search may have stopped early, don't leave its remaining entries behind
+	pq = std::priority_queue<QueueEntry>();
+	mq.clear();
 }
 
 CGPathNode *CPathfinder::getNode(const int3 &coord)
 {
-	return &out.nodes[coord.x][coord.y][coord.z];
+	return &out.getNode(coord);
+}
+
+const CPathfinder::TileObjects &CPathfinder::getObjects(const CGPathNode *node) const
+{
+	return tileObjects[node - out.nodes.data()];
 }
 
 bool CPathfinder::canMoveBetween(const int3 &a, const int3 &b) const
@@ -3561,7 +3645,7 @@ bool CPathfinder::goodForLandSeaTransition()
 	return true;
 }
 
-CPathfinder::CPathfinder(CPathsInfo &_out, CGameState *_gs, const CGHeroInstance *_hero) : CGameInfoCallback(_gs, boost::optional<PlayerColor>()), out(_out), hero(_hero), FoW(getPlayerTeam(hero->tempOwner)->fogOfWarMap)
+CPathfinder::CPathfinder(CPathsInfo &_out, CGameState *_gs, const CGHeroInstance *_hero, EQueueOrder _order) : CGameInfoCallback(_gs, boost::optional<PlayerColor>()), out(_out), hero(_hero), FoW(getPlayerTeam(hero->tempOwner)->fogOfWarMap), movementInfo(_hero), order(_order)
 {
 	assert(hero);
 	assert(hero == getHero(hero->id));
@@ -278,6 +278,13 @@ struct DLL_EXPORT DuelParameters
 
 class CPathfinder : private CGameInfoCallback
 {
+public:
+	enum EQueueOrder
+	{
+		PRIORITY, //nodes are expanded in order of (turns, -moveRemains)
+		FIFO //old breadth-first relaxation, kept for regression checks
+	};
+
 private:
 	bool allowEmbarkAndDisembark;
 	bool allowTeleportTwoWay; // Two-way monoliths and Subterranean Gate
@@ -287,9 +294,28 @@ private:
 	CPathsInfo &out;
 	const CGHeroInstance *hero;
 	const std::vector<std::vector<std::vector<ui8> > > &FoW;
+	HeroMovementInfo movementInfo;
+
+	struct TileObjects
+	{
+		const CGObjectInstance *top; //top visitable object, nullptr if there is none
+		const CGTeleport *teleport; //same object if it's a teleport
+	};
+	std::vector<TileObjects> tileObjects; //[node index] -> filled by initializeGraph, so neighbours are checked without RTTI
+	std::vector<int3> neighbourTiles; //reused between nodes
 
-	std::list<CGPathNode*> mq; //BFS queue -> nodes to be checked
+	struct QueueEntry
+	{
+		ui8 turns;
+		ui32 moveRemains;
+		CGPathNode *node;
+
+		bool operator<(const QueueEntry &other) const; //"less" means "worse", so std::priority_queue yields the best label first
+	};
 
+	EQueueOrder order;
+	std::priority_queue<QueueEntry> pq; //nodes to be checked, best (turns, moveRemains) label first; may contain stale entries
+	std::deque<CGPathNode*> mq; //BFS queue -> nodes to be checked (FIFO order only)
 
 	int3 curPos;
 	CGPathNode *cp; //current (source) path node -> we took it from the queue
@@ -300,7 +326,11 @@ private:
 
 
 	CGPathNode *getNode(const int3 &coord);
+	const TileObjects &getObjects(const CGPathNode *node) const;
 	void initializeGraph();
+	void pushNode(CGPathNode *node);
+	CGPathNode *popNode(); //returns nullptr when there is nothing left to check
+	void search(const int3 &dst); //dst outside the map -> calculate whole map
 	bool goodForLandSeaTransition(); //checks if current move will be between sea<->land. If so, checks it legality (returns false if movement is not possible) and sets useEmbarkCost
 
 	CGPathNode::EAccessibility evaluateAccessibility(const TerrainTile *tinfo) const;
@@ -312,8 +342,9 @@ private:
 	bool addTeleportWhirlpool(const CGWhirlpool * obj) const;
 
 public:
-	CPathfinder(CPathsInfo &_out, CGameState *_gs, const CGHeroInstance *_hero);
+	CPathfinder(CPathsInfo &_out, CGameState *_gs, const CGHeroInstance *_hero, EQueueOrder _order = PRIORITY);
 	void calculatePaths(); //calculates possible paths for hero, uses current hero position and movement left; returns pointer to newly allocated CPath or nullptr if path does not exists
+	void calculatePaths(const int3 &dst); //stops as soon as path to dst is known; info about other tiles may be incomplete
 };
 
 
@@ -362,6 +393,7 @@ public:
 	PlayerRelations::PlayerRelations getPlayerRelations(PlayerColor color1, PlayerColor color2);
 	bool checkForVisitableDir(const int3 & src, const int3 & dst) const; //check if src tile is visitable from dst tile
 	void calculatePaths(const CGHeroInstance *hero, CPathsInfo &out); //calculates possible paths for hero, by default uses current hero position and movement left; returns pointer to newly allocated CPath or nullptr if path does not exists
+	void calculatePaths(const CGHeroInstance *hero, const int3 &dst, CPathsInfo &out); //as above but stops once path to dst is known, only path to dst is valid afterwards
 	int3 guardingCreaturePosition (int3 pos) const;
 	std::vector<CGObjectInstance*> guardingCreatures (int3 pos) const;
 
@@ -380,7 +412,7 @@ public:
 	bool isVisible(const CGObjectInstance *obj, boost::optional<PlayerColor> player);
 
 	void getNeighbours(const TerrainTile &srct, int3 tile, std::vector<int3> &vec, const boost::logic::tribool &onLand, bool limitCoastSailing);
-	int getMovementCost(const CGHeroInstance *h, const int3 &src, const int3 &dest, bool flying, int remainingMovePoints=-1, bool checkLast=true);
+	int getMovementCost(const CGHeroInstance *h, const int3 &src, const int3 &dest, bool flying, int remainingMovePoints=-1, bool checkLast=true, const HeroMovementInfo *info = nullptr);
 	int getDate(Date::EDateType mode=Date::DAY) const; //mode=0 - total days in game, mode=1 - day of week, mode=2 - current week, mode=3 - current month
 
 	// ----- getters, setters -----
@@ -12,6 +12,7 @@
 
 class CQuest;
 class CGObjectInstance;
+class CGHeroInstance;
 
 class DLL_LINKAGE EVictoryLossCheckResult
 {
@@ -140,6 +141,16 @@ struct DLL_LINKAGE CGPathNode
 	bool reachable() const;
 };
 
+/// Hero properties needed for every pathfinder step which do not change during single pathfinder run
+struct DLL_LINKAGE HeroMovementInfo
+{
+	ui32 terrainCost[GameConstants::TERRAIN_TYPES]; //cost of leaving tile of given terrain when there is no road, with pathfinding and native army applied
+	bool freeFlying; //no penalty for flying over blocked tiles
+	bool waterWalkingPenalty; //hero walks on water without boat and pays for it
+
+	HeroMovementInfo(const CGHeroInstance *h);
+};
+
 struct DLL_LINKAGE CGPath
 {
 	std::vector<CGPathNode> nodes; //just get node by node
@@ -156,11 +167,19 @@ struct DLL_LINKAGE CPathsInfo
 	const CGHeroInstance *hero;
 	int3 hpos;
 	int3 sizes;
-	CGPathNode ***nodes; //[w][h][level]
+	std::vector<CGPathNode> nodes; //single buffer for whole map, laid out as [w][h][level] like map tiles; reused by every calculatePaths call
 
 	const CGPathNode * getPathInfo( int3 tile ) const;
 	bool getPath(const int3 &dst, CGPath &out) const;
 	int getDistance( int3 tile ) const;
 	CPathsInfo(const int3 &Sizes);
-	~CPathsInfo();
+
+	CGPathNode & getNode(const int3 &coord)
+	{
+		return nodes[(coord.x * sizes.y + coord.y) * sizes.z + coord.z];
+	}
+	const CGPathNode & getNode(const int3 &coord) const
+	{
+		return nodes[(coord.x * sizes.y + coord.y) * sizes.z + coord.z];
+	}
 };
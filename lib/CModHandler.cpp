@@ -13,6 +13,10 @@
 #include "mapObjects/CObjectHandler.h"
 #include "StringConstants.h"
 #include "CStopWatch.h"
+#include "CProfiler.h"
+#include "CThreadHelper.h"
+#include "Connection.h"
+#include "VCMIDirs.h"
 #include "IHandlerBase.h"
 #include "spells/CSpellHandler.h"
 
@@ -292,10 +296,9 @@ CContentHandler::ContentTypeHandler::ContentTypeHandler(IHandlerBase * handler,
 	}
 }
 
-bool CContentHandler::ContentTypeHandler::preloadModData(std::string modName, std::vector<std::string> fileList, bool validate)
+bool CContentHandler::ContentTypeHandler::preloadModData(std::string modName, JsonNode data, bool validate)
 {
-	bool result;
-	JsonNode data = JsonUtils::assembleFromFiles(fileList, result);
+	bool result = true;
 	data.setMeta(modName);
 
 	ModInfo & modInfo = modData[modName];
@@ -389,12 +392,12 @@ CContentHandler::CContentHandler()
 	//TODO: any other types of moddables?
 }
 
-bool CContentHandler::preloadModData(std::string modName, JsonNode modConfig, bool validate)
+bool CContentHandler::preloadModData(std::string modName, std::map<std::string, JsonNode> & modContent, bool validate)
 {
 	bool result = true;
 	for(auto & handler : handlers)
 	{
-		result &= handler.second.preloadModData(modName, modConfig[handler.first].convertTo<std::vector<std::string> >(), validate);
+		result &= handler.second.preloadModData(modName, std::move(modContent[handler.first]), validate);
 	}
 	return result;
 }
@@ -417,21 +420,158 @@ void CContentHandler::afterLoadFinalization()
 	}
 }
 
-void CContentHandler::preloadData(CModInfo & mod)
+static boost::filesystem::path getModCachePath(const CModInfo & mod)
 {
-	bool validate = (mod.validation != CModInfo::PASSED);
+	return VCMIDirs::get().userCachePath() / "modCache" / (mod.identifier + ".vmcache");
+}
+
+/// Files of a mod are read through global filesystem, so any active mod may override what is cached
+/// Cache is therefore valid only for the same list of loaded mods with the same checksums
+static ui32 calculateCacheKey(const std::vector<CModInfo *> & mods)
+{
+	boost::crc_32_type key;
+	for(const CModInfo * mod : mods)
+	{
+		key.process_bytes(reinterpret_cast<const void *>(mod->identifier.data()), mod->identifier.size() + 1); // with terminating zero
+		key.process_bytes(reinterpret_cast<const void *>(&mod->checksum), sizeof(mod->checksum));
+	}
+	return key.checksum();
+}
+
+static bool loadModCache(const CModInfo & mod, ui32 cacheKey, std::map<std::string, JsonNode> & modContent)
+{
+	auto path = getModCachePath(mod);
+	if (!boost::filesystem::exists(path))
+		return false;
+
+	try
+	{
+		CLoadFile file(path);
+		ui32 key;
+		file >> key;
+		if (key != cacheKey)
+			return false;
+
+		file >> modContent;
+		return true;
+	}
+	catch(std::exception & e)
+	{
+		logGlobal->warnStream() << "Failed to read cached data of mod " << mod.identifier << ": " << e.what();
+		modContent.clear();
+		return false;
+	}
+}
+
+static void saveModCache(const CModInfo & mod, ui32 cacheKey, const std::map<std::string, JsonNode> & modContent)
+{
+	auto path = getModCachePath(mod);
+	auto tempPath = path;
+	tempPath += ".tmp";
+	try
+	{
+		boost::filesystem::create_directories(path.parent_path());
+		{
+			CSaveFile file(tempPath.string());
+			file << cacheKey << modContent;
+		}
+		// partially written cache must never be seen by next start
+		boost::filesystem::rename(tempPath, path);
+	}
+	catch(std::exception & e)
+	{
+		logGlobal->warnStream() << "Failed to cache data of mod " << mod.identifier << ": " << e.what();
+	}
+}
+
+void CContentHandler::preloadData(const std::vector<CModInfo *> & mods)
+{
+	std::vector<std::map<std::string, JsonNode> > modContent(mods.size()); // [mod][content type] -> data merged from all files
+	std::vector<ui8> cached(mods.size(), false);
+	const ui32 cacheKey = calculateCacheKey(mods);
+
+	// constructing serializers is not thread-safe, so cache is read sequentially
+	for(size_t i = 0; i < mods.size(); i++)
+		cached[i] = loadModCache(*mods[i], cacheKey, modContent[i]);
+
+	// reading, parsing and validation of mod config don't depend on other mods, so all files are processed in parallel
+	std::vector<std::map<std::string, std::vector<JsonNode> > > parsedFiles(mods.size()); // [mod][content type] -> files
+	std::vector<ui8> configValid(mods.size(), true);
+	std::vector<Task> tasks;
+	boost::mutex errorMx;
+	std::exception_ptr error; // first failure of file loading, rethrown on calling thread
+
+	for(size_t i = 0; i < mods.size(); i++)
+	{
+		const CModInfo * mod = mods[i];
+		if (!cached[i])
+		{
+			for(auto & handler : handlers)
+			{
+				auto fileList = mod->config[handler.first].convertTo<std::vector<std::string> >();
+				auto & files = parsedFiles[i][handler.first];
+				files.resize(fileList.size());
+
+				for(size_t j = 0; j < fileList.size(); j++)
+				{
+					JsonNode * destination = &files[j];
+					std::string name = fileList[j];
+					tasks.push_back([=, &errorMx, &error]
+					{
+						try
+						{
+							*destination = JsonNode(ResourceID(name, EResType::TEXT));
+						}
+						catch(...)
+						{
+							boost::unique_lock<boost::mutex> lock(errorMx);
+							if(!error)
+								error = std::current_exception();
+						}
+					});
+				}
+			}
+		}
+		if (mod->validation != CModInfo::PASSED && mod->identifier != "core")
+		{
+			tasks.push_back([=, &configValid]
+			{
+				configValid[i] = JsonUtils::validate(mod->config, "vcmi:mod", mod->identifier);
+			});
+		}
+	}
 
-	// print message in format [<8-symbols checksum>] <modname>
-	logGlobal->infoStream() << "\t\t[" << std::noshowbase << std::hex << std::setw(8) << std::setfill('0')
-							<< mod.checksum << "] " << mod.name;
+	CThreadHelper th(&tasks, std::max((ui32)1, boost::thread::hardware_concurrency()));
+	th.run();
+	if(error)
+		std::rethrow_exception(error);
 
-	if (validate && mod.identifier != "core")
+	// mods may patch each other, so merging is done in load order
+	for(size_t i = 0; i < mods.size(); i++)
 	{
-		if (!JsonUtils::validate(mod.config, "vcmi:mod", mod.identifier))
+		CModInfo & mod = *mods[i];
+		bool validate = (mod.validation != CModInfo::PASSED);
+
+		// print message in format [<8-symbols checksum>] <modname>
+		logGlobal->infoStream() << "\t\t[" << std::noshowbase << std::hex << std::setw(8) << std::setfill('0')
+								<< mod.checksum << "] " << mod.name << (cached[i] ? " (cached)" : "");
+
+		if (!cached[i])
+		{
+			for(auto & entry : parsedFiles[i])
+			{
+				JsonNode & data = modContent[i][entry.first];
+				for(auto & file : entry.second)
+					JsonUtils::merge(data, file);
+			}
+			saveModCache(mod, cacheKey, modContent[i]);
+		}
+
+		if (!configValid[i])
+			mod.validation = CModInfo::FAILED;
+		if (!preloadModData(mod.identifier, modContent[i], validate))
 			mod.validation = CModInfo::FAILED;
 	}
-	if (!preloadModData(mod.identifier, mod.config, validate))
-		mod.validation = CModInfo::FAILED;
 }
 
 void CContentHandler::load(CModInfo & mod)
@@ -798,9 +938,35 @@ static ui32 calculateModChecksum(const std::string modName, ISimpleResourceLoade
 				 boost::starts_with(resID.getName(), "CONFIG"));
 	});
 
-	for (const ResourceID & file : files)
+	// files are read in parallel, but added to checksum in the same order as before
+	std::vector<ResourceID> fileList(files.begin(), files.end());
+	std::vector<ui32> fileChecksums(fileList.size());
+	std::vector<Task> tasks;
+	boost::mutex errorMx;
+	std::exception_ptr error; // first failure of file reading, rethrown on calling thread
+	for (size_t i = 0; i < fileList.size(); i++)
+	{
+		tasks.push_back([&, i]
+		{
+			try
+			{
+				fileChecksums[i] = filesystem->load(fileList[i])->calculateCRC32();
+			}
+			catch(...)
+			{
+				boost::unique_lock<boost::mutex> lock(errorMx);
+				if(!error)
+					error = std::current_exception();
+			}
+		});
+	}
+	CThreadHelper th(&tasks, std::max((ui32)1, boost::thread::hardware_concurrency()));
+	th.run();
+	if(error)
+		std::rethrow_exception(error);
+
+	for (ui32 fileChecksum : fileChecksums)
 	{
-		ui32 fileChecksum = filesystem->load(file)->calculateCRC32();
 		modChecksum.process_bytes(reinterpret_cast<const void *>(&fileChecksum), sizeof(fileChecksum));
 	}
 	return modChecksum.checksum();
@@ -833,36 +999,51 @@ void CModHandler::initializeConfig()
 
 void CModHandler::load()
 {
+	PROFILE_ZONE("CModHandler::load");
 	CStopWatch totalTime, timer;
 
 	CContentHandler content;
 	logGlobal->infoStream() << "\tInitializing content handler: " << timer.getDiff() << " ms";
 
-	for(const TModID & modName : activeMods)
 	{
-		logGlobal->traceStream() << "Generating checksum for " << modName;
-		allMods[modName].updateChecksum(calculateModChecksum(modName, CResourceHandler::get(modName)));
+		PROFILE_ZONE("Mod checksums");
+		for(const TModID & modName : activeMods)
+		{
+			logGlobal->traceStream() << "Generating checksum for " << modName;
+			allMods[modName].updateChecksum(calculateModChecksum(modName, CResourceHandler::get(modName)));
+		}
 	}
 
-	// first - load virtual "core" mod that contains all data
-	// TODO? move all data into real mods? RoE, AB, SoD, WoG
-	content.preloadData(coreMod);
-	for(const TModID & modName : activeMods)
-		content.preloadData(allMods[modName]);
+	{
+		PROFILE_ZONE("Parsing mod data");
+		// first - load virtual "core" mod that contains all data
+		// TODO? move all data into real mods? RoE, AB, SoD, WoG
+		std::vector<CModInfo *> modsToLoad = {&coreMod};
+		for(const TModID & modName : activeMods)
+			modsToLoad.push_back(&allMods[modName]);
+		content.preloadData(modsToLoad);
+	}
 	logGlobal->infoStream() << "\tParsing mod data: " << timer.getDiff() << " ms";
 
-	content.load(coreMod);
-	for(const TModID & modName : activeMods)
-		content.load(allMods[modName]);
+	{
+		PROFILE_ZONE("Loading mod data");
+		content.load(coreMod);
+		for(const TModID & modName : activeMods)
+			content.load(allMods[modName]);
+	}
 
 	logGlobal->infoStream() << "\tLoading mod data: " << timer.getDiff() << "ms";
 
 	VLC->creh->loadCrExpBon();
 	VLC->creh->buildBonusTreeForTiers(); //do that after all new creatures are loaded
 
-	identifiers.finalize();
+	{
+		PROFILE_ZONE("Resolving identifiers");
+		identifiers.finalize();
+	}
 	logGlobal->infoStream() << "\tResolving identifiers: " << timer.getDiff() << " ms";
 
+	PROFILE_ZONE("Handlers post-load finalization");
 	content.afterLoadFinalization();
 	logGlobal->infoStream() << "\tHandlers post-load finalization: " << timer.getDiff() << " ms";
 	logGlobal->infoStream() << "\tAll game content loaded in " << totalTime.getDiff() << " ms";
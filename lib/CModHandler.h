@@ -126,13 +126,13 @@ class CContentHandler
 
 		/// local version of methods in ContentHandler
 		/// returns true if loading was successful
-		bool preloadModData(std::string modName, std::vector<std::string> fileList, bool validate);
+		bool preloadModData(std::string modName, JsonNode data, bool validate);
 		bool loadMod(std::string modName, bool validate);
 		void afterLoadFinalization();
 	};
 
-	/// preloads all data from fileList as data from modName.
-	bool preloadModData(std::string modName, JsonNode modConfig, bool validate);
+	/// preloads data of mod modName merged from all its files, key is name of content type.
+	bool preloadModData(std::string modName, std::map<std::string, JsonNode> & modContent, bool validate);
 
 	/// actually loads data in mod
 	bool loadMod(std::string modName, bool validate);
@@ -142,8 +142,9 @@ public:
 	/// fully initialize object. Will cause reading of H3 config files
 	CContentHandler();
 
-	/// preloads all data from fileList as data from modName.
-	void preloadData(CModInfo & mod);
+	/// preloads data of all mods, files are parsed in parallel but merged in order of mods in list
+	/// data of mods with unchanged checksum is read from cache instead of parsing
+	void preloadData(const std::vector<CModInfo *> & mods);
 
 	/// actually loads data in mod
 	void load(CModInfo & mod);
@@ -0,0 +1,132 @@
+#include "StdInc.h"
+#include "CProfiler.h"
+
+#include "JsonNode.h"
+
+#include <atomic>
+
+/*
+ * CProfiler.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+namespace
+{
+	struct Zone
+	{
+		std::string name;
+		si64 begin, end;
+		ui32 thread;
+	};
+
+	struct ProfilerData
+	{
+		boost::mutex mx;
+		boost::filesystem::path outputFile;
+		std::vector<Zone> zones;
+		std::map<boost::thread::id, ui32> threads; //thread -> small number shown in trace
+		std::atomic<bool> enabled;
+
+		ProfilerData() : enabled(false) {}
+	};
+
+	ProfilerData & data()
+	{
+		static ProfilerData instance;
+		return instance;
+	}
+
+	const std::chrono::steady_clock::time_point profilerEpoch = std::chrono::steady_clock::now();
+}
+
+void CProfiler::start(const boost::filesystem::path & outputFile)
+{
+	auto & d = data();
+	{
+		boost::unique_lock<boost::mutex> lock(d.mx);
+		if (d.enabled)
+			return;
+		d.outputFile = outputFile;
+	}
+	std::atexit(&CProfiler::save); //registered after data is created, so it runs before data is destroyed
+	d.enabled = true;
+	logGlobal->infoStream() << "Profiling enabled, results will be written to " << outputFile;
+}
+
+bool CProfiler::isEnabled()
+{
+	return data().enabled;
+}
+
+si64 CProfiler::now()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - profilerEpoch).count();
+}
+
+void CProfiler::addZone(const std::string & name, si64 begin, si64 end)
+{
+	auto & d = data();
+	boost::unique_lock<boost::mutex> lock(d.mx);
+
+	auto thread = boost::this_thread::get_id();
+	if (!vstd::contains(d.threads, thread))
+	{
+		ui32 number = d.threads.size();
+		d.threads[thread] = number;
+	}
+
+	Zone zone = {name, begin, end, d.threads[thread]};
+	d.zones.push_back(zone);
+}
+
+void CProfiler::save()
+{
+	auto & d = data();
+	boost::unique_lock<boost::mutex> lock(d.mx);
+	if (!d.enabled)
+		return;
+
+	JsonNode trace;
+	auto & events = trace["traceEvents"].Vector();
+	for (auto & zone : d.zones)
+	{
+		JsonNode event;
+		event["name"].String() = zone.name;
+		event["ph"].String() = "X"; //complete event - with begin and duration
+		event["ts"].Float() = zone.begin;
+		event["dur"].Float() = zone.end - zone.begin;
+		event["pid"].Float() = 1;
+		event["tid"].Float() = zone.thread;
+		events.push_back(event);
+	}
+	trace["displayTimeUnit"].String() = "ms";
+
+	//no logging here - called at exit, when console used by logger may be already destroyed
+	std::ofstream file(d.outputFile.c_str(), std::ofstream::trunc);
+	file << trace;
+}
+
+CProfilerZone::CProfilerZone(const char * Name):
+	begin(CProfiler::isEnabled() ? CProfiler::now() : -1)
+{
+	if (begin >= 0)
+		name = Name;
+}
+
+CProfilerZone::CProfilerZone(const std::string & Name):
+	begin(CProfiler::isEnabled() ? CProfiler::now() : -1)
+{
+	if (begin >= 0)
+		name = Name;
+}
+
+CProfilerZone::~CProfilerZone()
+{
+	if (begin >= 0)
+		CProfiler::addZone(name, begin, CProfiler::now());
+}
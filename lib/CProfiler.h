@@ -0,0 +1,42 @@
+#pragma once
+
+#include <boost/preprocessor/cat.hpp>
+
+/*
+ * CProfiler.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+/// Collects timed zones from all threads and writes them as Chrome trace (can be opened in chrome://tracing)
+/// Until start() is called zones are not recorded and cost only a flag check
+class DLL_LINKAGE CProfiler
+{
+public:
+	/// starts recording, zones are written to outputFile when application exits
+	static void start(const boost::filesystem::path & outputFile);
+	static bool isEnabled();
+	/// writes zones recorded so far to output file
+	static void save();
+
+	/// wall time in microseconds, monotonic
+	static si64 now();
+	static void addZone(const std::string & name, si64 begin, si64 end);
+};
+
+/// Records time between its construction and destruction as one zone, nested scopes give nested zones
+class DLL_LINKAGE CProfilerZone
+{
+	std::string name; //copied only while recording, names built at runtime are temporaries
+	si64 begin;
+public:
+	CProfilerZone(const char * Name);
+	CProfilerZone(const std::string & Name);
+	~CProfilerZone();
+};
+
+#define PROFILE_ZONE(NAME) CProfilerZone BOOST_PP_CAT(profilerZone, __LINE__)(NAME)
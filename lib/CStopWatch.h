@@ -1,14 +1,6 @@
 #pragma once
 
-#ifdef __FreeBSD__
-	#include <sys/types.h>
-	#include <sys/time.h>
-	#include <sys/resource.h>
-	#define TO_MS_DIVISOR (1000)
-#else
-	#include <ctime>
-	#define TO_MS_DIVISOR (CLOCKS_PER_SEC / 1000)
-#endif
+#include <chrono>
 
 /*
  * timeHandler.h, part of VCMI engine
@@ -20,6 +12,7 @@
  *
  */
 
+/// Measures wall time using monotonic clock, see CProfiler.h for recording timeline of nested zones
 class CStopWatch
 {
 	si64 start, last, mem;
@@ -36,7 +29,7 @@ public:
 	{
 		si64 ret = clock() - last;
 		last = clock();
-		return ret / TO_MS_DIVISOR;
+		return ret;
 	}
 	void update()
 	{
@@ -48,18 +41,12 @@ public:
 	}
 	si64 memDif()
 	{
-		return (clock()-mem) / TO_MS_DIVISOR;
+		return clock()-mem;
 	}
 
 private:
 	si64 clock() 
 	{
-	#ifdef __FreeBSD__
-		struct rusage usage;
-		getrusage(RUSAGE_SELF, &usage);
-		return static_cast<si64>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
-	#else
-		return std::clock();
-	#endif
+		return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
 	}
 };
@@ -2,8 +2,11 @@
 #include "Connection.h"
 
 #include "registerTypes/RegisterTypes.h"
+#include "filesystem/CCompressedStream.h"
+#include "filesystem/CFileInputStream.h"
 
 #include <boost/asio.hpp>
+#include <zlib.h>
 
 /*
  * Connection.cpp, part of VCMI engine
@@ -40,6 +43,11 @@ CTypeList typeList;
 
 void CConnection::init()
 {
+	readPos = 0;
+	writeBuffer.assign(4, 0);
+	sendQueueBytes = 0;
+	stopSending = false;
+	sender = nullptr;
 	boost::asio::ip::tcp::no_delay option(true);
 	socket->set_option(option);
 
@@ -56,8 +64,10 @@ void CConnection::init()
 	std::string pom;
 	//we got connection
 	oser << std::string("Aiya!\n") << name << myEndianess; //identify ourselves
+	asio::write(*socket, asio::buffer(*takeFrame())); //sender is started only for established connection, failed handshake throws and leaves nothing behind
 	iser >> pom >> pom >> contactEndianess;
     logNetwork->infoStream() << "Established connection with "<<pom;
+	sender = new boost::thread(&CConnection::sendFrames, this);
 	wmx = new boost::mutex;
 	rmx = new boost::mutex;
 
@@ -144,34 +154,144 @@ CConnection::CConnection(TAcceptor * acceptor, boost::asio::io_service *Io_servi
 int CConnection::write(const void * data, unsigned size)
 {
 	//LOG("Sending " << size << " byte(s) of data" <<std::endl);
-	try
+	const ui8 *bytes = static_cast<const ui8 *>(data);
+	writeBuffer.insert(writeBuffer.end(), bytes, bytes + size);
+	return size;
+}
+void CConnection::flush()
+{
+	if(writeBuffer.size() == 4)
+		return;
+
+	sendFrame(takeFrame());
+}
+std::shared_ptr<const std::vector<ui8>> CConnection::takeFrame()
+{
+	if(writeBuffer.size() - 4 > MAX_FRAME_SIZE)
+		throw std::runtime_error(boost::str(boost::format("Frame of %d bytes for %s exceeds limit of %d bytes") % (writeBuffer.size() - 4) % name % static_cast<ui32>(MAX_FRAME_SIZE)));
+
+	//frame length is always little endian, before contact endianness is known we already need it
+	const ui32 length = writeBuffer.size() - 4;
+	writeBuffer[0] = length;
+	writeBuffer[1] = length >> 8;
+	writeBuffer[2] = length >> 16;
+	writeBuffer[3] = length >> 24;
+
+	auto frame = std::make_shared<const std::vector<ui8>>(std::move(writeBuffer));
+	writeBuffer.assign(4, 0);
+	return frame;
+}
+void CConnection::sendFrame(std::shared_ptr<const std::vector<ui8>> frame)
+{
 	{
-		int ret;
-		ret = asio::write(*socket,asio::const_buffers_1(asio::const_buffer(data,size)));
-		return ret;
+		boost::unique_lock<boost::mutex> lock(sendMx);
+		//slow peer makes the one sending wait instead of queueing without limit; single bigger frame is accepted once queue is empty
+		sentCond.wait(lock, [&]
+		{
+			return !connected || stopSending || sendQueue.empty() || sendQueueBytes + frame->size() <= SEND_QUEUE_LIMIT;
+		});
+		if(!connected || stopSending)
+			return;
+
+		sendQueueBytes += frame->size();
+		sendQueue.push_back(frame);
+		if(sendQueueBytes > SEND_QUEUE_WARNING && sendQueueBytes - frame->size() <= SEND_QUEUE_WARNING)
+		{
+			logNetwork->warnStream() << boost::format("Connection to %s is falling behind: %d frames (%d bytes) waiting to be sent")
+				% name % sendQueue.size() % sendQueueBytes;
+		}
 	}
-	catch(...)
+	sendCond.notify_one();
+}
+void CConnection::sendFrames()
+{
+	boost::unique_lock<boost::mutex> lock(sendMx);
+	while(true)
 	{
-		//connection has been lost
-		connected = false;
-		throw;
+		sendCond.wait(lock, [this]{ return !sendQueue.empty() || stopSending; });
+		if(sendQueue.empty())
+			break; //stopped and everything is sent
+
+		auto frame = sendQueue.front();
+		lock.unlock();
+		try
+		{
+			asio::write(*socket, asio::buffer(*frame));
+		}
+		catch(std::exception &e)
+		{
+			//connection has been lost
+			logNetwork->errorStream() << "Sending to " << name << " failed: " << e.what();
+			lock.lock();
+			connected = false;
+			sendQueue.clear();
+			sendQueueBytes = 0;
+			sentCond.notify_all();
+			break;
+		}
+		lock.lock();
+		sendQueueBytes -= frame->size();
+		sendQueue.pop_front();
+		sentCond.notify_all();
 	}
 }
-int CConnection::read(void * data, unsigned size)
+size_t CConnection::getPendingFrames() const
+{
+	boost::unique_lock<boost::mutex> lock(sendMx);
+	return sendQueue.size();
+}
+size_t CConnection::getPendingBytes() const
+{
+	boost::unique_lock<boost::mutex> lock(sendMx);
+	return sendQueueBytes;
+}
+void CConnection::readFrame()
 {
-	//LOG("Receiving " << size << " byte(s) of data" <<std::endl);
 	try
 	{
-		int ret = asio::read(*socket,asio::mutable_buffers_1(asio::mutable_buffer(data,size)));
-		return ret;
+		ui8 header[4];
+		asio::read(*socket, asio::buffer(header));
+		const ui32 length = header[0] | (header[1] << 8) | (header[2] << 16) | (ui32(header[3]) << 24);
+		if(length > MAX_FRAME_SIZE)
+		{
+			//corrupted stream or malicious peer, don't let it make us allocate gigabytes
+			logNetwork->errorStream() << boost::format("Received frame of %d bytes from %s, limit is %d. Closing connection.") % length % name % static_cast<ui32>(MAX_FRAME_SIZE);
+			boost::system::error_code ec;
+			socket->shutdown(tcp::socket::shutdown_both, ec);
+			throw std::runtime_error("Frame too big");
+		}
+
+		readBuffer.resize(length);
+		readPos = 0;
+		asio::read(*socket, asio::buffer(readBuffer));
 	}
 	catch(...)
 	{
 		//connection has been lost
 		connected = false;
+		readBuffer.clear();
+		readPos = 0;
 		throw;
 	}
 }
+int CConnection::read(void * data, unsigned size)
+{
+	//LOG("Receiving " << size << " byte(s) of data" <<std::endl);
+	ui8 *bytes = static_cast<ui8 *>(data);
+	unsigned remaining = size;
+	while(remaining)
+	{
+		if(readPos == readBuffer.size())
+			readFrame();
+
+		const unsigned chunk = std::min<size_t>(remaining, readBuffer.size() - readPos);
+		std::copy(readBuffer.begin() + readPos, readBuffer.begin() + readPos + chunk, bytes);
+		readPos += chunk;
+		bytes += chunk;
+		remaining -= chunk;
+	}
+	return size;
+}
 CConnection::~CConnection(void)
 {
 	if(handler)
@@ -196,6 +316,27 @@ CConnection & CConnection::operator&(const T &t) {
 
 void CConnection::close()
 {
+	if(sender)
+	{
+		{
+			boost::unique_lock<boost::mutex> lock(sendMx);
+			stopSending = true;
+		}
+		sendCond.notify_one();
+		sentCond.notify_all();
+
+		//give sender some time to write what is queued, but don't wait forever for stalled peer
+		if(!sender->timed_join(boost::posix_time::seconds(5)))
+		{
+			logNetwork->warnStream() << "Connection to " << name << " doesn't accept data, dropping what wasn't sent";
+			boost::system::error_code ec;
+			socket->shutdown(tcp::socket::shutdown_both, ec); //blocked write fails and sender ends
+			sender->join();
+		}
+		delete sender;
+		sender = nullptr;
+	}
+
 	if(socket)
 	{
 		socket->close();
@@ -217,6 +358,8 @@ void CConnection::reportState(CLogger * out)
         out->debugStream() << "\tWe have an open and valid socket";
         out->debugStream() << "\t" << socket->available() <<" bytes awaiting";
 	}
+	boost::unique_lock<boost::mutex> lock(sendMx);
+	out->debugStream() << "\t" << sendQueue.size() << " frames (" << sendQueueBytes << " bytes) waiting to be sent";
 }
 
 CPack * CConnection::retreivePack()
@@ -234,6 +377,7 @@ void CConnection::sendPackToServer(const CPack &pack, PlayerColor player, ui32 r
 	boost::unique_lock<boost::mutex> lock(*wmx);
     logNetwork->traceStream() << "Sending to server a pack of type " << typeid(pack).name();
 	oser << player << requestID << &pack; //packs has to be sent as polymorphic pointers!
+	flush();
 }
 
 void CConnection::disableStackSendingByID()
@@ -283,7 +427,7 @@ void CConnection::enableSmartVectorMemberSerializatoin()
 	CSerializer::smartVectorMembersSerialization = true;
 }
 
-CSaveFile::CSaveFile( const std::string &fname ): serializer(this) 
+CSaveFile::CSaveFile( const std::string &fname, bool Deferred ): serializer(this), deferred(Deferred), deflateState(nullptr)
 {
 	registerTypes(serializer);
 	openNextFile(fname);
@@ -291,26 +435,106 @@ CSaveFile::CSaveFile( const std::string &fname ): serializer(this)
 
 CSaveFile::~CSaveFile()
 {
+	try
+	{
+		finishFile();
+	}
+	catch(std::exception &e)
+	{
+		logGlobal->errorStream() << "Failed to finish writing " << fName << ": " << e.what();
+	}
+	clear();
 }
 
 int CSaveFile::write( const void * data, unsigned size )
 {
-	sfile->write((char *)data,size);
+	if(deferred)
+	{
+		auto oldSize = buffer.size();
+		buffer.resize(oldSize + size);
+		std::memcpy(buffer.data() + oldSize, data, size);
+	}
+	else
+		writeToFile(data, size);
 	return size;
 }
 
+void CSaveFile::startFile()
+{
+	sfile = make_unique<std::ofstream>(fName.c_str(), std::ios::binary);
+	sfile->exceptions(std::ifstream::failbit | std::ifstream::badbit); //we throw a lot anyway
+
+	if(!(*sfile))
+		THROW_FORMAT("Error: cannot open to write %s!", fName);
+
+	sfile->write(COMPRESSED_FILE_MAGIC.c_str(), COMPRESSED_FILE_MAGIC.size()); //write magic identifier
+
+	deflateState = new z_stream;
+	deflateState->zalloc = Z_NULL;
+	deflateState->zfree = Z_NULL;
+	deflateState->opaque = Z_NULL;
+	//saving is often done on game thread, most of size reduction is achieved by fastest level anyway
+	if(deflateInit(deflateState, Z_BEST_SPEED) != Z_OK)
+	{
+		delete deflateState;
+		deflateState = nullptr;
+		throw std::runtime_error("Failed to initialize deflate!");
+	}
+	compressedBuffer.resize(64 * 1024);
+}
+
+void CSaveFile::writeToFile( const void * data, unsigned size )
+{
+	deflateState->next_in = (Bytef *)data;
+	deflateState->avail_in = size;
+	do
+	{
+		deflateState->next_out = compressedBuffer.data();
+		deflateState->avail_out = compressedBuffer.size();
+		deflate(deflateState, Z_NO_FLUSH);
+		sfile->write((char *)compressedBuffer.data(), compressedBuffer.size() - deflateState->avail_out);
+	}
+	while(deflateState->avail_out == 0);
+}
+
+void CSaveFile::finishFile()
+{
+	if(!deflateState)
+		return;
+
+	deflateState->avail_in = 0;
+	int ret;
+	do
+	{
+		deflateState->next_out = compressedBuffer.data();
+		deflateState->avail_out = compressedBuffer.size();
+		ret = deflate(deflateState, Z_FINISH);
+		sfile->write((char *)compressedBuffer.data(), compressedBuffer.size() - deflateState->avail_out);
+	}
+	while(ret == Z_OK);
+
+	deflateEnd(deflateState);
+	delete deflateState;
+	deflateState = nullptr;
+	compressedBuffer.clear();
+	compressedBuffer.shrink_to_fit();
+
+	if(ret != Z_STREAM_END)
+		throw std::runtime_error("Compression error. Return code was " + boost::lexical_cast<std::string>(ret));
+	sfile = nullptr;
+}
+
 void CSaveFile::openNextFile(const std::string &fname)
 {
+	finishFile();
 	fName = fname;
 	try
 	{
-		sfile = make_unique<std::ofstream>(fname.c_str(), std::ios::binary);
-		sfile->exceptions(std::ifstream::failbit | std::ifstream::badbit); //we throw a lot anyway
-
-		if(!(*sfile))
-			THROW_FORMAT("Error: cannot open to write %s!", fname);
+		if(deferred)
+			buffer.clear();
+		else
+			startFile();
 
-		sfile->write("VCMI",4); //write magic identifier
 		serializer << version; //write format version
 	}
 	catch(...)
@@ -321,6 +545,29 @@ void CSaveFile::openNextFile(const std::string &fname)
 	}
 }
 
+void CSaveFile::writeDeferred()
+{
+	assert(deferred);
+	//write to temporary file and move it into place, so nobody can load half written save
+	const std::string finalName = fName;
+	fName = finalName + ".tmp";
+	try
+	{
+		startFile();
+		writeToFile(buffer.data(), buffer.size());
+		finishFile();
+		fName = finalName;
+		boost::filesystem::rename(finalName + ".tmp", finalName);
+	}
+	catch(...)
+	{
+		clear();
+		throw;
+	}
+	buffer.clear();
+	buffer.shrink_to_fit();
+}
+
 void CSaveFile::reportState(CLogger * out)
 {
     out->debugStream() << "CSaveFile";
@@ -334,6 +581,13 @@ void CSaveFile::clear()
 {
 	fName.clear();
 	sfile = nullptr;
+	buffer.clear();
+	if(deflateState)
+	{
+		deflateEnd(deflateState);
+		delete deflateState;
+		deflateState = nullptr;
+	}
 }
 
 void CSaveFile::putMagicBytes( const std::string &text )
@@ -341,7 +595,7 @@ void CSaveFile::putMagicBytes( const std::string &text )
 	write(text.c_str(), text.length());
 }
 
-CLoadFile::CLoadFile(const boost::filesystem::path & fname, int minimalVersion /*= version*/): serializer(this)
+CLoadFile::CLoadFile(const boost::filesystem::path & fname, int minimalVersion /*= version*/): serializer(this), position(0)
 {
 	registerTypes(serializer);
 	openNextFile(fname, minimalVersion);
@@ -353,7 +607,14 @@ CLoadFile::~CLoadFile()
 
 int CLoadFile::read(void * data, unsigned size)
 {
-	sfile->read((char*)data,size);
+	if(decompressed)
+	{
+		if(decompressed->read((ui8*)data, size) != size)
+			THROW_FORMAT("Error: unexpected end of file %s!", fName);
+	}
+	else
+		sfile->read((char*)data,size);
+	position += size;
 	return size;
 }
 
@@ -365,6 +626,7 @@ void CLoadFile::openNextFile(const boost::filesystem::path & fname, int minimalV
 	try
 	{
 		fName = fname.string();
+		decompressed = nullptr;
 		sfile = make_unique<boost::filesystem::ifstream>(fname, std::ios::binary);
 		sfile->exceptions(std::ifstream::failbit | std::ifstream::badbit); //we throw a lot anyway
 
@@ -372,9 +634,12 @@ void CLoadFile::openNextFile(const boost::filesystem::path & fname, int minimalV
 			THROW_FORMAT("Error: cannot open to read %s!", fName);
 
 		//we can read
-		char buffer[4];
-		sfile->read(buffer, 4);
-		if(std::memcmp(buffer,"VCMI",4))
+		std::string magic(FILE_MAGIC.size(), '\0');
+		sfile->read(&magic[0], magic.size());
+		position = magic.size();
+		if(magic == COMPRESSED_FILE_MAGIC)
+			decompressed = make_unique<CCompressedStream>(make_unique<CFileInputStream>(fname, magic.size()), false);
+		else if(magic != FILE_MAGIC)
 			THROW_FORMAT("Error: not a VCMI file(%s)!", fName);
 
 		serializer >> serializer.fileVersion;	
@@ -410,12 +675,13 @@ void CLoadFile::reportState(CLogger * out)
     out->debugStream() << "CLoadFile";
 	if(!!sfile && *sfile)
 	{
-        out->debugStream() << "\tOpened " << fName << "\n\tPosition: " << sfile->tellg();
+        out->debugStream() << "\tOpened " << fName << "\n\tPosition: " << position;
 	}
 }
 
 void CLoadFile::clear()
 {
+	decompressed = nullptr;
 	sfile = nullptr;
 	fName.clear();
 	serializer.fileVersion = 0;
@@ -443,14 +709,14 @@ CTypeList::TypeInfoPtr CTypeList::registerType( const std::type_info *type )
 	auto newType = make_shared<TypeDescriptor>();
 	newType->typeID = typeInfos.size() + 1;
 	newType->name = type->name();
-	typeInfos[type] = newType;
+	typeInfos[std::type_index(*type)] = newType;
 
 	return newType;
 }
 
 ui16 CTypeList::getTypeID( const std::type_info *type )
 {
-	auto i = typeInfos.find(type);
+	auto i = typeInfos.find(std::type_index(*type));
 	if(i != typeInfos.end())
 		return i->second->typeID;
 	else
@@ -520,9 +786,41 @@ std::vector<CTypeList::TypeInfoPtr> CTypeList::castSequence(const std::type_info
 	return castSequence(getTypeDescriptor(from), getTypeDescriptor(to));
 }
 
+const CTypeList::TCasterChain & CTypeList::getCasterChain(const std::type_info *from, const std::type_info *to)
+{
+	static const TCasterChain noCasting;
+	if(*from == *to) //as above, unregistered type may be "casted" to itself
+		return noCasting;
+
+	auto fromDescr = getTypeDescriptor(from), toDescr = getTypeDescriptor(to);
+	const ui32 key = (ui32(fromDescr->typeID) << 16) | toDescr->typeID;
+
+	{
+		boost::shared_lock<boost::shared_mutex> lock(castChainsMx);
+		auto i = castChains.find(key);
+		if(i != castChains.end())
+			return i->second;
+	}
+
+	auto typesSequence = castSequence(fromDescr, toDescr);
+	TCasterChain chain;
+	for(int i = 0; i < (int)typesSequence.size() - 1; i++)
+	{
+		auto castingPair = std::make_pair(typesSequence[i], typesSequence[i + 1]);
+		if(!casters.count(castingPair))
+			THROW_FORMAT("Cannot find caster for conversion %s -> %s which is needed to cast %s -> %s", castingPair.first->name % castingPair.second->name % from->name() % to->name());
+
+		chain.push_back(casters.at(castingPair).get());
+	}
+
+	//elements of unordered_map are never moved, so reference stays valid after lock is released
+	boost::unique_lock<boost::shared_mutex> lock(castChainsMx);
+	return castChains.insert(std::make_pair(key, std::move(chain))).first->second;
+}
+
 CTypeList::TypeInfoPtr CTypeList::getTypeDescriptor(const std::type_info *type, bool throws)
 {
-	auto i = typeInfos.find(type);
+	auto i = typeInfos.find(std::type_index(*type));
 	if(i != typeInfos.end())
 		return i->second; //type found, return ptr to structure	
 
@@ -596,7 +894,7 @@ int CLoadIntegrityValidator::read( void * data, unsigned size )
 		controlFile->read(controlData.data(), size);
 		if(std::memcmp(data, controlData.data(), size))
 		{
-            logGlobal->errorStream() << "Desync found! Position: " << primaryFile->sfile->tellg();
+            logGlobal->errorStream() << "Desync found! Position: " << primaryFile->position;
 			foundDesync = true;
 			//throw std::runtime_error("Savegame dsynchronized!");
 		}
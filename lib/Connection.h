@@ -13,6 +13,7 @@
 
 #include <typeinfo> //XXX this is in namespace std if you want w/o use typeinfo.h?
 #include <type_traits>
+#include <typeindex>
 
 #include <boost/mpl/eval_if.hpp>
 #include <boost/mpl/equal_to.hpp>
@@ -33,6 +34,8 @@ const ui32 minSupportedVersion = version;
 class CISer;
 class COSer;
 class CConnection;
+class CInputStream;
+struct z_stream_s;
 class CGObjectInstance;
 class CStackInstance;
 class CGameState;
@@ -44,6 +47,8 @@ extern DLL_LINKAGE LibClasses * VLC;
 namespace mpl = boost::mpl;
 
 const std::string SAVEGAME_MAGIC = "VCMISVG";
+const std::string FILE_MAGIC = "VCMI"; //file identifier, rest of the file is stored as is
+const std::string COMPRESSED_FILE_MAGIC = "VCMZ"; //rest of the file (format version included) is zlib stream
 
 namespace boost
 {
@@ -147,11 +152,15 @@ public:
 		const char *name;
 		std::vector<TypeInfoPtr> children, parents;
 	};
+	typedef std::vector<const IPointerCaster *> TCasterChain;
 private:
 
-	std::map<const std::type_info *, TypeInfoPtr, TypeComparer> typeInfos;
+	std::unordered_map<std::type_index, TypeInfoPtr> typeInfos;
 	std::map<std::pair<TypeInfoPtr, TypeInfoPtr>, std::unique_ptr<const IPointerCaster>> casters; //for each pair <Base, Der> we provide a caster (each registered relations creates a single entry here)
 
+	boost::shared_mutex castChainsMx;
+	std::unordered_map<ui32, TCasterChain> castChains; //[from typeID << 16 | to typeID] -> casters to apply one after another; filled on first use, never changed afterwards
+
 	CTypeList(CTypeList &)
 	{
 		// This type is non-copyable.
@@ -202,23 +211,15 @@ public:
 	std::vector<TypeInfoPtr> castSequence(TypeInfoPtr from, TypeInfoPtr to);
 	std::vector<TypeInfoPtr> castSequence(const std::type_info *from, const std::type_info *to);
 
+	// Casters that together convert "from" to "to", found by castSequence on first use and remembered. Safe to call from many threads.
+	const TCasterChain & getCasterChain(const std::type_info *from, const std::type_info *to);
+
 	template<boost::any(IPointerCaster::*CastingFunction)(const boost::any &) const>
 	boost::any castHelper(boost::any inputPtr, const std::type_info *fromArg, const std::type_info *toArg)
 	{
-		auto typesSequence = castSequence(fromArg, toArg);
-
 		boost::any ptr = inputPtr;
-		for(int i = 0; i < (int)typesSequence.size() - 1; i++)
-		{
-			auto &from = typesSequence[i];
-			auto &to = typesSequence[i + 1];
-			auto castingPair = std::make_pair(from, to);
-			if(!casters.count(castingPair))
-				THROW_FORMAT("Cannot find caster for conversion %s -> %s which is needed to cast %s -> %s", from->name % to->name % fromArg->name() % toArg->name());
-
-			auto &caster = casters.at(castingPair);
-			ptr = (*caster.*CastingFunction)(ptr); //Why does unique_ptr does not have operator->* ..?
-		}
+		for(const IPointerCaster *caster : getCasterChain(fromArg, toArg))
+			ptr = (caster->*CastingFunction)(ptr);
 
 		return ptr;
 	}
@@ -1538,18 +1539,27 @@ public:
 class DLL_LINKAGE CSaveFile
 	:public IBinaryWriter
 {
+	void startFile(); //opens file and writes identifier
+	void writeToFile(const void * data, unsigned size); //compresses data and writes it to the opened file
+	void finishFile(); //flushes compressor and closes file
 public:
 	
 	COSer serializer;
 	
 	std::string fName;
 	unique_ptr<std::ofstream> sfile;
+	bool deferred; //if true, data is kept in buffer until writeDeferred is called
+	std::vector<ui8> buffer;
+
+	z_stream_s * deflateState; //everything after file identifier is compressed
+	std::vector<ui8> compressedBuffer;
 
-	CSaveFile(const std::string &fname); //throws!
+	CSaveFile(const std::string &fname, bool Deferred = false); //throws!
 	~CSaveFile();
 	int write(const void * data, unsigned size) override;
 
 	void openNextFile(const std::string &fname); //throws!
+	void writeDeferred(); //throws! compresses buffered data and writes it to the file (replacing it at once), serializer must not be used meanwhile
 	void clear();
     void reportState(CLogger * out);
 
@@ -1571,6 +1581,8 @@ public:
 		
 	std::string fName;
 	unique_ptr<boost::filesystem::ifstream> sfile;
+	unique_ptr<CInputStream> decompressed; //used instead of sfile for compressed files
+	si64 position; //offset in uncompressed data (magic included), the same for compressed and plain file
 
 	CLoadFile(const boost::filesystem::path & fname, int minimalVersion = version); //throws!
 	~CLoadFile();
@@ -1615,7 +1627,27 @@ class DLL_LINKAGE CConnection
 	//CGameState *gs;
 	CConnection(void);
 
+	//everything written is kept in memory and sent as single length-prefixed frame on flush, reading takes whole frames from socket
+	std::vector<ui8> writeBuffer; //starts with space for frame header
+	std::vector<ui8> readBuffer;
+	size_t readPos; //index of the next byte to be read from readBuffer
+
+	//flushed frames are written to socket by separate thread, so slow peer doesn't block the one sending
+	mutable boost::mutex sendMx;
+	boost::condition_variable sendCond; //signalled when frame is queued or sending should stop
+	boost::condition_variable sentCond; //signalled when sender takes frame off the queue
+	std::deque<std::shared_ptr<const std::vector<ui8>>> sendQueue; //complete frames, header included; may be shared with other connections
+	size_t sendQueueBytes;
+	static const size_t SEND_QUEUE_WARNING = 16 * 1024 * 1024; //queue size logged as falling behind peer
+	static const size_t SEND_QUEUE_LIMIT = 64 * 1024 * 1024; //sendFrame waits until queue is smaller than this
+	bool stopSending;
+	boost::thread *sender;
+
+	static const ui32 MAX_FRAME_SIZE = 256 * 1024 * 1024; //larger frame header is treated as corrupted stream
+
 	void init();
+	void readFrame(); //replaces readBuffer content with the next frame from socket
+	void sendFrames(); //sender thread body
     void reportState(CLogger * out);
 public:
 	CISer iser;
@@ -1624,7 +1656,7 @@ public:
 	boost::mutex *rmx, *wmx; // read/write mutexes
 	TSocket * socket;
 	bool logging;
-	bool connected;
+	std::atomic<bool> connected; //cleared by reading or sending thread when connection is lost
 	bool myEndianess, contactEndianess; //true if little endian, if endianness is different we'll have to revert received multi-byte vars
     boost::asio::io_service *io_service;
 	std::string name; //who uses this connection
@@ -1640,7 +1672,12 @@ public:
 
 	int write(const void * data, unsigned size) override;
 	int read(void * data, unsigned size) override;
-	void close();
+	void flush(); //queues data written since last flush for sending, doesn't wait for it
+	std::shared_ptr<const std::vector<ui8>> takeFrame(); //returns data written since last flush as a frame instead of sending it
+	void sendFrame(std::shared_ptr<const std::vector<ui8>> frame); //queues frame made by takeFrame, possibly of another connection; waits if too much is queued already
+	size_t getPendingFrames() const; //frames flushed but not yet written to socket
+	size_t getPendingBytes() const;
+	void close(); //sends everything queued, then closes socket
 	bool isOpen() const;
     template<class T>
     CConnection &operator&(const T&);
@@ -1670,6 +1707,7 @@ public:
 	CConnection & operator<<(const T &t)
 	{
 		oser << t;
+		flush();
 		return * this;
 	}
 };
@@ -82,10 +82,11 @@ const std::map<std::string, TPropagatorPtr> bonusPropagatorMap =
 
 #define BONUS_LOG_LINE(x) logBonus->traceStream() << x
 
-int CBonusSystemNode::treeChanged = 1;
+std::atomic<si64> CBonusSystemNode::changeCounter(1);
+std::atomic<si64> CBonusSystemNode::treeChanged(1);
 const bool CBonusSystemNode::cachingEnabled = true;
 
-BonusList::BonusList(bool BelongsToTree /* =false */) : belongsToTree(BelongsToTree)
+BonusList::BonusList(CBonusSystemNode *Owner /* = nullptr */) : owner(Owner)
 {
 
 }
@@ -94,14 +95,19 @@ BonusList::BonusList(const BonusList &bonusList)
 {
 	bonuses.resize(bonusList.size());
 	std::copy(bonusList.begin(), bonusList.end(), bonuses.begin());
-	belongsToTree = false;
+	owner = nullptr;
+}
+
+BonusList::BonusList(const BonusList &bonusList, CBonusSystemNode *Owner)
+	: bonuses(bonusList.bonuses), owner(Owner)
+{
 }
 
 BonusList& BonusList::operator=(const BonusList &bonusList)
 {
 	bonuses.resize(bonusList.size());
 	std::copy(bonusList.begin(), bonusList.end(), bonuses.begin());
-	belongsToTree = false;
+	changed();
 	return *this;
 }
 
@@ -268,18 +274,82 @@ void BonusList::eliminateDuplicates()
 	bonuses.erase( unique( bonuses.begin(), bonuses.end() ), bonuses.end() );
 }
 
+BonusRequestCache::BonusRequestCache() : used(0)
+{
+
+}
+
+size_t BonusRequestCache::findSlot(ui64 key) const
+{
+	const size_t mask = slots.size() - 1;
+	size_t pos = (key * 0x9E3779B97F4A7C15ULL) >> 32; //Fibonacci hashing, keys differ mostly in low bits
+	while(true)
+	{
+		pos &= mask;
+		if(slots[pos].first == key || slots[pos].first == 0)
+			return pos;
+		pos++;
+	}
+}
+
+void BonusRequestCache::grow()
+{
+	auto oldSlots = std::move(slots);
+	slots.clear();
+	slots.resize(std::max<size_t>(16, oldSlots.size() * 2));
+
+	for(auto & slot : oldSlots)
+		if(slot.first)
+			slots[findSlot(slot.first)] = std::move(slot);
+}
+
+TBonusListPtr BonusRequestCache::find(const BonusCacheKey &key) const
+{
+	if(!used)
+		return nullptr;
+
+	return slots[findSlot(key.value)].second;
+}
+
+void BonusRequestCache::insert(const BonusCacheKey &key, TBonusListPtr bonuses)
+{
+	assert(key.isSet());
+	if((used + 1) * 2 > slots.size()) //keep load factor below 1/2 so probe sequences stay short
+		grow();
+
+	auto & slot = slots[findSlot(key.value)];
+	if(!slot.first)
+		used++;
+	slot.first = key.value;
+	slot.second = bonuses;
+}
+
+void BonusRequestCache::clear()
+{
+	if(!used)
+		return;
+
+	for(auto & slot : slots)
+		slot = std::make_pair(0, nullptr);
+	used = 0;
+}
+
+void BonusList::changed()
+{
+	if(owner)
+		owner->nodeHasChanged();
+}
+
 void BonusList::push_back(Bonus* const &x)
 {
 	bonuses.push_back(x);
 
-	if (belongsToTree)
-		CBonusSystemNode::incrementTreeChangedNum();
+	changed();
 }
 
 std::vector<Bonus*>::iterator BonusList::erase(const int position)
 {
-	if (belongsToTree)
-		CBonusSystemNode::incrementTreeChangedNum();
+	changed();
 	return bonuses.erase(bonuses.begin() + position);
 }
 
@@ -287,8 +357,7 @@ void BonusList::clear()
 {
 	bonuses.clear();
 
-	if (belongsToTree)
-		CBonusSystemNode::incrementTreeChangedNum();
+	changed();
 }
 
 std::vector<BonusList*>::size_type BonusList::operator-=(Bonus* const &i)
@@ -298,8 +367,7 @@ std::vector<BonusList*>::size_type BonusList::operator-=(Bonus* const &i)
 		return false;
 	bonuses.erase(itr);
 
-	if (belongsToTree)
-		CBonusSystemNode::incrementTreeChangedNum();
+	changed();
 	return true;
 }
 
@@ -307,16 +375,14 @@ void BonusList::resize(std::vector<Bonus*>::size_type sz, Bonus* c )
 {
 	bonuses.resize(sz, c);
 
-	if (belongsToTree)
-		CBonusSystemNode::incrementTreeChangedNum();
+	changed();
 }
 
 void BonusList::insert(std::vector<Bonus*>::iterator position, std::vector<Bonus*>::size_type n, Bonus* const &x)
 {
 	bonuses.insert(position, n, x);
 
-	if (belongsToTree)
-		CBonusSystemNode::incrementTreeChangedNum();
+	changed();
 }
 
 int IBonusBearer::valOfBonuses(Bonus::BonusType type, const CSelector &selector) const
@@ -326,77 +392,65 @@ int IBonusBearer::valOfBonuses(Bonus::BonusType type, const CSelector &selector)
 
 int IBonusBearer::valOfBonuses(Bonus::BonusType type, int subtype /*= -1*/) const
 {
-	std::stringstream cachingStr;
-	cachingStr << "type_" << type << "s_" << subtype;
-
 	CSelector s = Selector::type(type);
 	if(subtype != -1)
 		s = s.And(Selector::subtype(subtype));
 
-	return valOfBonuses(s, cachingStr.str());
+	return valOfBonuses(s, BonusCacheKey::type(type, subtype));
 }
 
-int IBonusBearer::valOfBonuses(const CSelector &selector, const std::string &cachingStr) const
+int IBonusBearer::valOfBonuses(const CSelector &selector, const BonusCacheKey &cachingKey) const
 {
 	CSelector limit = nullptr;
-	TBonusListPtr hlp = getAllBonuses(selector, limit, nullptr, cachingStr);
+	TBonusListPtr hlp = getAllBonuses(selector, limit, nullptr, cachingKey);
 	return hlp->totalValue();
 }
-bool IBonusBearer::hasBonus(const CSelector &selector, const std::string &cachingStr /*= ""*/) const
+bool IBonusBearer::hasBonus(const CSelector &selector, const BonusCacheKey &cachingKey /*= BonusCacheKey()*/) const
 {
-	return getBonuses(selector, cachingStr)->size() > 0;
+	return getBonuses(selector, cachingKey)->size() > 0;
 }
 
 bool IBonusBearer::hasBonusOfType(Bonus::BonusType type, int subtype /*= -1*/) const
 {
-	std::stringstream cachingStr;
-	cachingStr << "type_" << type << "s_" << subtype;
-
 	CSelector s = Selector::type(type);
 	if(subtype != -1)
 		s = s.And(Selector::subtype(subtype));
 
-	return hasBonus(s, cachingStr.str());
+	return hasBonus(s, BonusCacheKey::type(type, subtype));
 }
 
 void IBonusBearer::getModifiersWDescr(TModDescr &out, Bonus::BonusType type, int subtype /*= -1 */) const
 {
-	std::stringstream cachingStr;
-	cachingStr << "type_" << type << "s_" << subtype;
-	getModifiersWDescr(out, subtype != -1 ? Selector::typeSubtype(type, subtype) : Selector::type(type), cachingStr.str());
+	getModifiersWDescr(out, subtype != -1 ? Selector::typeSubtype(type, subtype) : Selector::type(type), BonusCacheKey::type(type, subtype));
 }
 
-void IBonusBearer::getModifiersWDescr(TModDescr &out, const CSelector &selector, const std::string &cachingStr /* =""*/) const
+void IBonusBearer::getModifiersWDescr(TModDescr &out, const CSelector &selector, const BonusCacheKey &cachingKey /*= BonusCacheKey()*/) const
 {
-	getBonuses(selector, cachingStr)->getModifiersWDescr(out);
+	getBonuses(selector, cachingKey)->getModifiersWDescr(out);
 }
 int IBonusBearer::getBonusesCount(Bonus::BonusSource from, int id) const
 {
-	std::stringstream cachingStr;
-	cachingStr << "source_" << from << "id_" << id;
-	return getBonusesCount(Selector::source(from, id), cachingStr.str());
+	return getBonusesCount(Selector::source(from, id), BonusCacheKey::source(from, id));
 }
 
-int IBonusBearer::getBonusesCount(const CSelector &selector, const std::string &cachingStr /* =""*/) const
+int IBonusBearer::getBonusesCount(const CSelector &selector, const BonusCacheKey &cachingKey /*= BonusCacheKey()*/) const
 {
-	return getBonuses(selector, cachingStr)->size();
+	return getBonuses(selector, cachingKey)->size();
 }
 
-const TBonusListPtr IBonusBearer::getBonuses(const CSelector &selector, const std::string &cachingStr /*= ""*/) const
+const TBonusListPtr IBonusBearer::getBonuses(const CSelector &selector, const BonusCacheKey &cachingKey /*= BonusCacheKey()*/) const
 {
-	return getAllBonuses(selector, nullptr, nullptr, cachingStr);
+	return getAllBonuses(selector, nullptr, nullptr, cachingKey);
 }
 
-const TBonusListPtr IBonusBearer::getBonuses(const CSelector &selector, const CSelector &limit, const std::string &cachingStr /*= ""*/) const
+const TBonusListPtr IBonusBearer::getBonuses(const CSelector &selector, const CSelector &limit, const BonusCacheKey &cachingKey /*= BonusCacheKey()*/) const
 {
-	return getAllBonuses(selector, limit, nullptr, cachingStr);
+	return getAllBonuses(selector, limit, nullptr, cachingKey);
 }
 
 bool IBonusBearer::hasBonusFrom(Bonus::BonusSource source, ui32 sourceID) const
 {
-	std::stringstream cachingStr;
-	cachingStr << "source_" << source << "id_" << sourceID;
-	return hasBonus(Selector::source(source,sourceID), cachingStr.str());
+	return hasBonus(Selector::source(source,sourceID), BonusCacheKey::source(source, sourceID));
 }
 
 int IBonusBearer::MoraleVal() const
@@ -459,15 +513,11 @@ ui32 IBonusBearer::MaxHealth() const
 
 ui32 IBonusBearer::getMinDamage() const
 {
-	std::stringstream cachingStr;
-	cachingStr << "type_" << Bonus::CREATURE_DAMAGE << "s_0Otype_" << Bonus::CREATURE_DAMAGE << "s_1";
-	return valOfBonuses(Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 0).Or(Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 1)), cachingStr.str());
+	return valOfBonuses(Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 0).Or(Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 1)), BonusCacheKey::special(BonusCacheKey::MIN_DAMAGE));
 }
 ui32 IBonusBearer::getMaxDamage() const
 {
-	std::stringstream cachingStr;
-	cachingStr << "type_" << Bonus::CREATURE_DAMAGE << "s_0Otype_" << Bonus::CREATURE_DAMAGE << "s_2";
-	return valOfBonuses(Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 0).Or(Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 2)), cachingStr.str());
+	return valOfBonuses(Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 0).Or(Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 2)), BonusCacheKey::special(BonusCacheKey::MAX_DAMAGE));
 }
 
 si32 IBonusBearer::manaLimit() const
@@ -514,18 +564,14 @@ ui32 IBonusBearer::Speed( int turn /*= 0*/ , bool useBind /* = false*/) const
 
 bool IBonusBearer::isLiving() const //TODO: theoreticaly there exists "LIVING" bonus in stack experience documentation
 {
-	std::stringstream cachingStr;
-	cachingStr << "type_" << Bonus::UNDEAD << "s_-1Otype_" << Bonus::NON_LIVING << "s_-11type_" << Bonus::SIEGE_WEAPON; //I don't really get what string labels mean?
 	return !hasBonus(Selector::type(Bonus::UNDEAD)
 					.Or(Selector::type(Bonus::NON_LIVING))
-					.Or(Selector::type(Bonus::SIEGE_WEAPON)), cachingStr.str());
+					.Or(Selector::type(Bonus::SIEGE_WEAPON)), BonusCacheKey::special(BonusCacheKey::IS_LIVING));
 }
 
 const TBonusListPtr IBonusBearer::getSpellBonuses() const
 {
-	std::stringstream cachingStr;
-	cachingStr << "source_" << Bonus::SPELL_EFFECT;
-	return getBonuses(Selector::sourceType(Bonus::SPELL_EFFECT), Selector::anyRange(), cachingStr.str());
+	return getBonuses(Selector::sourceType(Bonus::SPELL_EFFECT), Selector::anyRange(), BonusCacheKey::special(BonusCacheKey::SPELL_EFFECTS));
 }
 
 const Bonus * IBonusBearer::getEffect(ui16 id, int turn /*= 0*/) const
@@ -632,18 +678,36 @@ void CBonusSystemNode::getAllBonusesRec(BonusList &out) const
 	bonuses.getAllBonuses(out);
 }
 
-const TBonusListPtr CBonusSystemNode::getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root /*= nullptr*/, const std::string &cachingStr /*= ""*/) const
+const TBonusListPtr CBonusSystemNode::getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root /*= nullptr*/, const BonusCacheKey &cachingKey /*= BonusCacheKey()*/) const
 {
 	bool limitOnUs = (!root || root == this); //caching won't work when we want to limit bonuses against an external node
 	if (CBonusSystemNode::cachingEnabled && limitOnUs)
 	{
-		// Exclusive access for one thread
-		static boost::mutex m;
-		boost::mutex::scoped_lock lock(m);
+		// Fast path: any number of threads may read a valid cache of this node at the same time.
+		{
+			boost::shared_lock<boost::shared_mutex> lock(getCacheMutex());
+			if (cachedLast == getTreeVersion())
+			{
+				if (cachingKey.isSet())
+				{
+					if(auto cached = cachedRequests.find(cachingKey))
+						return cached;
+				}
+				else
+				{
+					auto ret = make_shared<BonusList>();
+					getCachedCandidates(cachingKey).getBonuses(*ret, selector, limit);
+					return ret;
+				}
+			}
+		}
+
+		// Exclusive access to the cache of this node, queries on nodes using other locks from the pool are not blocked
+		boost::unique_lock<boost::shared_mutex> lock(getCacheMutex());
 
 		// If the bonus system tree changes(state of a single node or the relations to each other) then
 		// cache all bonus objects. Selector objects doesn't matter.
-		if (cachedLast != treeChanged)
+		if (cachedLast != getTreeVersion())
 		{
 			cachedBonuses.clear();
 			cachedRequests.clear();
@@ -653,29 +717,35 @@ const TBonusListPtr CBonusSystemNode::getAllBonuses(const CSelector &selector, c
 			allBonuses.eliminateDuplicates();
 			limitBonuses(allBonuses, cachedBonuses);
 
-			cachedLast = treeChanged;
+			for(auto & bucket : cachedBonusesByType)
+				bucket.clear();
+			for(Bonus *b : cachedBonuses)
+			{
+				if(b->type >= cachedBonusesByType.size())
+					cachedBonusesByType.resize(b->type + 1);
+				cachedBonusesByType[b->type].push_back(b);
+			}
+
+			cachedLast = getTreeVersion();
 		}
 
-		// If a bonus system request comes with a caching string then look up in the map if there are any
-		// pre-calculated bonus results. Limiters can't be cached so they have to be calculated.
-		if (cachingStr != "")
+		// If a bonus system request comes with a caching key then look up in the table if there are any
+		// pre-calculated bonus results. Another thread may have added it while we were waiting for the lock.
+		if (cachingKey.isSet())
 		{
-			auto it = cachedRequests.find(cachingStr);
-			if(it != cachedRequests.end())
-			{
-				//Cached list contains bonuses for our query with applied limiters
-				return it->second;
-			}
+			//Cached list contains bonuses for our query with applied limiters
+			if(auto cached = cachedRequests.find(cachingKey))
+				return cached;
 		}
 
 		//We still don't have the bonuses (didn't returned them from cache)
 		//Perform bonus selection
 		auto ret = make_shared<BonusList>();
-		cachedBonuses.getBonuses(*ret, selector, limit);
+		getCachedCandidates(cachingKey).getBonuses(*ret, selector, limit);
 
 		// Save the results in the cache
-		if(cachingStr != "")
-			cachedRequests[cachingStr] = ret;
+		if(cachingKey.isSet())
+			cachedRequests.insert(cachingKey, ret);
 
 		return ret;
 	}
@@ -685,6 +755,18 @@ const TBonusListPtr CBonusSystemNode::getAllBonuses(const CSelector &selector, c
 	}
 }
 
+const BonusList & CBonusSystemNode::getCachedCandidates(const BonusCacheKey &cachingKey) const
+{
+	// Queries keyed by bonus type can only match bonuses from the bucket of that type
+	if(cachingKey.getKind() == BonusCacheKey::TYPE)
+	{
+		static const BonusList emptyBucket;
+		auto type = cachingKey.getType();
+		return type < cachedBonusesByType.size() ? cachedBonusesByType[type] : emptyBucket;
+	}
+	return cachedBonuses;
+}
+
 const TBonusListPtr CBonusSystemNode::getAllBonusesWithoutCaching(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root /*= nullptr*/) const
 {
 	auto ret = make_shared<BonusList>();
@@ -724,8 +806,28 @@ const TBonusListPtr CBonusSystemNode::getAllBonusesWithoutCaching(const CSelecto
 	return ret;
 }
 
-CBonusSystemNode::CBonusSystemNode() : bonuses(true), exportedBonuses(true), nodeType(UNKNOWN), cachedLast(0)
+CBonusSystemNode::CBonusSystemNode() : bonuses(this), exportedBonuses(this), nodeType(UNKNOWN), cachedLast(-1), nodeChanged(0)
+{
+}
+
+CBonusSystemNode::CBonusSystemNode(const CBonusSystemNode &other)
+	: bonuses(other.bonuses, this), exportedBonuses(other.exportedBonuses, this), parents(other.parents), children(other.children),
+	nodeType(other.nodeType), description(other.description), cachedLast(-1), nodeChanged(0)
 {
+	// Lists have to stay bound to this node (not to the copied one), otherwise changing them wouldn't invalidate caches.
+	// Nothing is invalidated, copy has no cache yet and copied children still belong to the other node.
+}
+
+CBonusSystemNode &CBonusSystemNode::operator=(const CBonusSystemNode &other)
+{
+	// BonusList assignment keeps owner and invalidates this subtree, so it's done while children are still our own
+	bonuses = other.bonuses;
+	exportedBonuses = other.exportedBonuses;
+	parents = other.parents;
+	children = other.children;
+	nodeType = other.nodeType;
+	description = other.description;
+	return *this;
 }
 
 CBonusSystemNode::~CBonusSystemNode()
@@ -754,7 +856,7 @@ void CBonusSystemNode::attachTo(CBonusSystemNode *parent)
 		newRedDescendant(parent);
 
 	parent->newChildAttached(this);
-	CBonusSystemNode::treeChanged++;
+	nodeHasChanged();
 }
 
 void CBonusSystemNode::detachFrom(CBonusSystemNode *parent)
@@ -768,7 +870,7 @@ void CBonusSystemNode::detachFrom(CBonusSystemNode *parent)
 
 	parents -= parent;
 	parent->childDetached(this);
-	CBonusSystemNode::treeChanged++;
+	nodeHasChanged();
 }
 
 void CBonusSystemNode::popBonuses(const CSelector &s)
@@ -792,7 +894,6 @@ void CBonusSystemNode::addNewBonus(Bonus *b)
 	assert(!vstd::contains(exportedBonuses,b));
 	exportedBonuses.push_back(b);
 	exportBonus(b);
-	CBonusSystemNode::treeChanged++;
 }
 
 void CBonusSystemNode::accumulateBonus(Bonus &b)
@@ -812,7 +913,6 @@ void CBonusSystemNode::removeBonus(Bonus *b)
 	else
 		bonuses -= b;
 	vstd::clear_pointer(b);
-	CBonusSystemNode::treeChanged++;
 }
 
 bool CBonusSystemNode::actsAsBonusSourceOnly() const
@@ -994,8 +1094,6 @@ void CBonusSystemNode::exportBonus(Bonus * b)
 		propagateBonus(b);
 	else
 		bonuses.push_back(b);
-
-	CBonusSystemNode::treeChanged++;
 }
 
 void CBonusSystemNode::exportBonuses()
@@ -1049,9 +1147,32 @@ void CBonusSystemNode::setDescription(const std::string &description)
 	this->description = description;
 }
 
-void CBonusSystemNode::incrementTreeChangedNum()
+void CBonusSystemNode::nodeHasChanged()
+{
+	invalidateSubtree(++changeCounter);
+}
+
+void CBonusSystemNode::invalidateSubtree(si64 stamp)
+{
+	if(nodeChanged == stamp)
+		return; //already reached through another parent
+
+	nodeChanged = stamp;
+	for(CBonusSystemNode *child : children)
+		child->invalidateSubtree(stamp);
+}
+
+boost::shared_mutex & CBonusSystemNode::getCacheMutex() const
+{
+	// Nodes are copyable (eg. PlayerState kept in std::map) so they can't own a mutex.
+	// Use a lock from fixed pool instead, nodes sharing a lock only compete for it.
+	static boost::shared_mutex locks[64];
+	return locks[(reinterpret_cast<uintptr_t>(this) / sizeof(CBonusSystemNode)) % 64];
+}
+
+si64 CBonusSystemNode::getTreeVersion() const
 {
-	treeChanged++;
+	return std::max(nodeChanged.load(), treeChanged.load());
 }
 
 void CBonusSystemNode::limitBonuses(const BonusList &allBonuses, BonusList &out) const
@@ -1098,7 +1219,7 @@ TBonusListPtr CBonusSystemNode::limitBonuses(const BonusList &allBonuses) const
 
 void CBonusSystemNode::treeHasChanged()
 {
-	treeChanged++;
+	treeChanged = ++changeCounter;
 }
 
 int NBonus::valOf(const CBonusSystemNode *obj, Bonus::BonusType type, int subtype /*= -1*/)
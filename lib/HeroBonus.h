@@ -391,6 +391,57 @@ struct DLL_LINKAGE Bonus
 
 DLL_LINKAGE std::ostream & operator<<(std::ostream &out, const Bonus &bonus);
 
+/// Compact key of a cacheable bonus query, packs query kind, bonus type (or source) and subtype (or source id)
+struct DLL_LINKAGE BonusCacheKey
+{
+	enum EKind : ui8 { NONE, TYPE, SOURCE, SPECIAL };
+	enum ESpecial { MIN_DAMAGE, MAX_DAMAGE, IS_LIVING, SPELL_EFFECTS }; //queries with composed selectors
+
+	ui64 value; //0 if query should not be cached
+
+	BonusCacheKey() : value(0) {}
+
+	static BonusCacheKey type(Bonus::BonusType type, TBonusSubtype subtype = -1) //subtype -1 means any subtype
+	{
+		return BonusCacheKey(TYPE, type, subtype);
+	}
+	static BonusCacheKey source(Bonus::BonusSource source, ui32 sourceID)
+	{
+		return BonusCacheKey(SOURCE, source, sourceID);
+	}
+	static BonusCacheKey special(ESpecial query)
+	{
+		return BonusCacheKey(SPECIAL, query, 0);
+	}
+
+	bool isSet() const { return value != 0; }
+	EKind getKind() const { return static_cast<EKind>(value >> 56); }
+	Bonus::BonusType getType() const { assert(getKind() == TYPE); return static_cast<Bonus::BonusType>((value >> 32) & 0xffff); }
+	bool operator==(const BonusCacheKey &other) const { return value == other.value; }
+
+private:
+	BonusCacheKey(EKind kind, ui16 primary, ui32 secondary)
+		: value((ui64(kind) << 56) | (ui64(primary) << 32) | secondary)
+	{}
+};
+
+/// Open addressing hash table of bonus query results
+class DLL_LINKAGE BonusRequestCache
+{
+	std::vector<std::pair<ui64, TBonusListPtr> > slots; //key 0 marks an empty slot, size is always power of 2
+	size_t used;
+
+	size_t findSlot(ui64 key) const; //returns slot holding key or empty slot where it should be inserted
+	void grow();
+
+public:
+	BonusRequestCache();
+
+	TBonusListPtr find(const BonusCacheKey &key) const; //nullptr if not cached
+	void insert(const BonusCacheKey &key, TBonusListPtr bonuses);
+	void clear();
+};
+
 
 class DLL_LINKAGE BonusList
 {
@@ -398,8 +449,9 @@ private:
 	typedef std::vector<Bonus*> TInternalContainer;
 
 	TInternalContainer bonuses;
-	bool belongsToTree;
+	CBonusSystemNode *owner; //node whose bonus tree this list belongs to, nullptr for standalone lists
 
+	void changed();
 
 public:
 	typedef TInternalContainer::const_reference const_reference;
@@ -408,9 +460,10 @@ public:
 	typedef TInternalContainer::const_iterator const_iterator;
 	typedef TInternalContainer::iterator iterator;
 
-	BonusList(bool BelongsToTree = false);
-	BonusList(const BonusList &bonusList);
-	BonusList& operator=(const BonusList &bonusList);
+	explicit BonusList(CBonusSystemNode *Owner = nullptr);
+	BonusList(const BonusList &bonusList); //copy is a standalone list
+	BonusList(const BonusList &bonusList, CBonusSystemNode *Owner); //copy bound to given node, which isn't notified
+	BonusList& operator=(const BonusList &bonusList); //keeps owner of assigned list
 
 	// wrapper functions of the STL vector container
 	std::vector<Bonus*>::size_type size() const { return bonuses.size(); }
@@ -462,6 +515,7 @@ public:
 		bonuses.clear();
 		bonuses.resize(newList.size());
 		std::copy(newList.begin(), newList.end(), bonuses.begin());
+		changed();
 	}
 
 	template <class InputIterator>
@@ -566,13 +620,14 @@ public:
 	// * selector is predicate that tests if HeroBonus matches our criteria
 	// * root is node on which call was made (nullptr will be replaced with this)
 	//interface
-	virtual const TBonusListPtr getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr, const std::string &cachingStr = "") const = 0;
-	void getModifiersWDescr(TModDescr &out, const CSelector &selector, const std::string &cachingStr = "") const;  //out: pairs<modifier value, modifier description>
-	int getBonusesCount(const CSelector &selector, const std::string &cachingStr = "") const;
-	int valOfBonuses(const CSelector &selector, const std::string &cachingStr = "") const;
-	bool hasBonus(const CSelector &selector, const std::string &cachingStr = "") const;
-	const TBonusListPtr getBonuses(const CSelector &selector, const CSelector &limit, const std::string &cachingStr = "") const;
-	const TBonusListPtr getBonuses(const CSelector &selector, const std::string &cachingStr = "") const;
+	// * cachingKey identifies the query if its result may be cached, it must describe the selector unambiguously
+	virtual const TBonusListPtr getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr, const BonusCacheKey &cachingKey = BonusCacheKey()) const = 0;
+	void getModifiersWDescr(TModDescr &out, const CSelector &selector, const BonusCacheKey &cachingKey = BonusCacheKey()) const;  //out: pairs<modifier value, modifier description>
+	int getBonusesCount(const CSelector &selector, const BonusCacheKey &cachingKey = BonusCacheKey()) const;
+	int valOfBonuses(const CSelector &selector, const BonusCacheKey &cachingKey = BonusCacheKey()) const;
+	bool hasBonus(const CSelector &selector, const BonusCacheKey &cachingKey = BonusCacheKey()) const;
+	const TBonusListPtr getBonuses(const CSelector &selector, const CSelector &limit, const BonusCacheKey &cachingKey = BonusCacheKey()) const;
+	const TBonusListPtr getBonuses(const CSelector &selector, const BonusCacheKey &cachingKey = BonusCacheKey()) const;
 
 	const TBonusListPtr getAllBonuses() const;
 	const Bonus *getBonus(const CSelector &selector) const; //returns any bonus visible on node that matches (or nullptr if none matches)
@@ -624,26 +679,33 @@ private:
 
 	static const bool cachingEnabled;
 	mutable BonusList cachedBonuses;
-	mutable int cachedLast;
-	static int treeChanged;
+	mutable std::vector<BonusList> cachedBonusesByType; //cachedBonuses split by bonus type, indexed by Bonus::BonusType
+	mutable si64 cachedLast; //tree version cachedBonuses and cachedRequests were built for
+	std::atomic<si64> nodeChanged; //stamp of the last change on this node or on any of its ancestors, read by querying threads without lock
+	static std::atomic<si64> changeCounter; //source of stamps, incremented on every change in the bonus system
+	static std::atomic<si64> treeChanged; //stamp of the last change invalidating every node (see treeHasChanged)
 
-	// Setting a value to cachingStr before getting any bonuses caches the result for later requests.
-	// This string needs to be unique, that's why it has to be setted in the following manner:
-	// [property key]_[value] => only for selector
-	mutable std::map<std::string, TBonusListPtr > cachedRequests;
+	// Passing a cachingKey when getting bonuses caches the result for later requests with the same key.
+	mutable BonusRequestCache cachedRequests;
 
 	void getBonusesRec(BonusList &out, const CSelector &selector, const CSelector &limit) const;
 	void getAllBonusesRec(BonusList &out) const;
 	const TBonusListPtr getAllBonusesWithoutCaching(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr) const;
+	void invalidateSubtree(si64 stamp);
+	boost::shared_mutex & getCacheMutex() const; //guards cachedBonuses, cachedLast and cachedRequests
+	const BonusList &getCachedCandidates(const BonusCacheKey &cachingKey) const; //smallest part of cachedBonuses that may match query
+	si64 getTreeVersion() const;
 
 public:
 
 	explicit CBonusSystemNode();
+	CBonusSystemNode(const CBonusSystemNode &other); //copy owns its bonus lists, caches are not copied
+	CBonusSystemNode &operator=(const CBonusSystemNode &other);
 	virtual ~CBonusSystemNode();
 
 	void limitBonuses(const BonusList &allBonuses, BonusList &out) const; //out will bo populed with bonuses that are not limited here
 	TBonusListPtr limitBonuses(const BonusList &allBonuses) const; //same as above, returns out by val for convienence
-	const TBonusListPtr getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr, const std::string &cachingStr = "") const;
+	const TBonusListPtr getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr, const BonusCacheKey &cachingKey = BonusCacheKey()) const;
 	void getParents(TCNodes &out) const;  //retrieves list of parent nodes (nodes to inherit bonuses from),
 	const Bonus *getBonusLocalFirst(const CSelector &selector) const;
 
@@ -683,7 +745,7 @@ public:
 	void exportBonus(Bonus * b);
 	void exportBonuses();
 
-	static void incrementTreeChangedNum();
+	void nodeHasChanged(); //invalidates cached bonuses of this node and all its descendants
 	BonusList &getBonusList();
 	const BonusList &getBonusList() const;
 	BonusList &getExportedBonusList();
@@ -694,7 +756,7 @@ public:
 	const std::string &getDescription() const;
 	void setDescription(const std::string &description);
 
-	static void treeHasChanged();
+	static void treeHasChanged(); //invalidates cached bonuses of all nodes, use when limiters depend on state outside of bonus tree
 
 	template <typename Handler> void serialize(Handler &h, const int version)
 	{
@@ -979,9 +1041,7 @@ template <class InputIterator>
 void BonusList::insert(const int position, InputIterator first, InputIterator last)
 {
 	bonuses.insert(bonuses.begin() + position, first, last);
-
-	if (belongsToTree)
-		CBonusSystemNode::incrementTreeChangedNum();
+	changed();
 }
 
 // Extensions for BOOST_FOREACH to enable iterating of BonusList objects
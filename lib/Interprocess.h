@@ -16,6 +16,12 @@
  *
  */
 
+/// name of memory shared with server listening at given port, so several local servers don't collide
+inline std::string serverReadyMemoryName(const std::string & port)
+{
+	return "vcmi_memory_" + port;
+}
+
 struct ServerReady
 {
 	bool ready;
@@ -39,12 +45,13 @@ struct ServerReady
 
 struct SharedMem 
 {
+	std::string name;
 	boost::interprocess::shared_memory_object smo;
 	boost::interprocess::mapped_region *mr;
 	ServerReady *sr;
 	
-	SharedMem() //c-tor
-		:smo(boost::interprocess::open_or_create,"vcmi_memory",boost::interprocess::read_write) 
+	SharedMem(const std::string & Name) //c-tor
+		:name(Name), smo(boost::interprocess::open_or_create,name.c_str(),boost::interprocess::read_write) 
 	{
 		smo.truncate(sizeof(ServerReady));
 		mr = new boost::interprocess::mapped_region(smo,boost::interprocess::read_write);
@@ -53,6 +60,6 @@ struct SharedMem
 	~SharedMem() //d-tor
 	{
 		delete mr;
-		boost::interprocess::shared_memory_object::remove("vcmi_memory");
+		boost::interprocess::shared_memory_object::remove(name.c_str());
 	}
 };
\ No newline at end of file
@@ -663,6 +663,8 @@ const JsonNode & getSchemaByName(std::string name)
 {
 	// cached schemas to avoid loading json data multiple times
 	static std::map<std::string, JsonNode> loadedSchemas;
+	static boost::mutex loadedSchemasMx; //mods are validated in parallel
+	boost::unique_lock<boost::mutex> lock(loadedSchemasMx);
 
 	if (vstd::contains(loadedSchemas, name))
 		return loadedSchemas[name];
@@ -24,6 +24,7 @@
 #include "CModHandler.h"
 #include "IGameEventsReceiver.h"
 #include "CStopWatch.h"
+#include "CProfiler.h"
 #include "VCMIDirs.h"
 #include "filesystem/Filesystem.h"
 #include "CConsoleHandler.h"
@@ -59,20 +60,30 @@ const IBonusTypeHandler * LibClasses::getBth() const
 
 void LibClasses::loadFilesystem()
 {
+	PROFILE_ZONE("LibClasses::loadFilesystem");
 	CStopWatch totalTime;
 	CStopWatch loadTime;
 
-	CResourceHandler::initialize();
+	{
+		PROFILE_ZONE("CResourceHandler::initialize");
+		CResourceHandler::initialize();
+	}
 	logGlobal->infoStream()<<"\t Initialization: "<<loadTime.getDiff();
 
-	CResourceHandler::load("config/filesystem.json");
+	{
+		PROFILE_ZONE("CResourceHandler::load");
+		CResourceHandler::load("config/filesystem.json");
+	}
 	logGlobal->infoStream()<<"\t Data loading: "<<loadTime.getDiff();
 
 	modh = new CModHandler;
 	logGlobal->infoStream()<<"\tMod handler: "<<loadTime.getDiff();
 
-	modh->loadMods();
-	modh->loadModFilesystems();
+	{
+		PROFILE_ZONE("Mod filesystems");
+		modh->loadMods();
+		modh->loadModFilesystems();
+	}
 	logGlobal->infoStream()<<"\t Mod filesystems: "<<loadTime.getDiff();
 
 	logGlobal->infoStream()<<"Basic initialization: "<<totalTime.getDiff();
@@ -85,12 +96,14 @@ static void logHandlerLoaded(const std::string& name, CStopWatch &timer)
 
 template <class Handler> void createHandler(Handler *&handler, const std::string &name, CStopWatch &timer)
 {
+	PROFILE_ZONE(name + " handler");
 	handler = new Handler();
 	logHandlerLoaded(name, timer);
 }
 
 void LibClasses::init()
 {
+	PROFILE_ZONE("LibClasses::init");
 	CStopWatch pomtime, totalTime;
 
 	modh->initializeConfig();
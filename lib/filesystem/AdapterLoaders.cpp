@@ -56,6 +56,7 @@ CFilesystemList::~CFilesystemList()
 
 std::unique_ptr<CInputStream> CFilesystemList::load(const ResourceID & resourceName) const
 {
+	boost::shared_lock<boost::shared_mutex> lock(mx);
 	// load resource from last loader that have it (last overridden version)
 	for (auto & loader : boost::adaptors::reverse(loaders))
 	{
@@ -69,6 +70,7 @@ std::unique_ptr<CInputStream> CFilesystemList::load(const ResourceID & resourceN
 
 bool CFilesystemList::existsResource(const ResourceID & resourceName) const
 {
+	boost::shared_lock<boost::shared_mutex> lock(mx);
 	for (auto & loader : loaders)
 		if (loader->existsResource(resourceName))
 			return true;
@@ -82,8 +84,13 @@ std::string CFilesystemList::getMountPoint() const
 
 boost::optional<std::string> CFilesystemList::getResourceName(const ResourceID & resourceName) const
 {
-	if (existsResource(resourceName))
-		return getResourcesWithName(resourceName).back()->getResourceName(resourceName);
+	boost::shared_lock<boost::shared_mutex> lock(mx);
+	// same as last entry of getResourcesWithName, without locking twice
+	for (auto & loader : boost::adaptors::reverse(loaders))
+	{
+		if (loader->existsResource(resourceName))
+			return loader->getResourcesWithName(resourceName).back()->getResourceName(resourceName);
+	}
 	return boost::optional<std::string>();
 }
 
@@ -91,6 +98,7 @@ std::unordered_set<ResourceID> CFilesystemList::getFilteredFiles(std::function<b
 {
 	std::unordered_set<ResourceID> ret;
 
+	boost::shared_lock<boost::shared_mutex> lock(mx);
 	for (auto & loader : loaders)
 		for (auto & entry : loader->getFilteredFiles(filter))
 			ret.insert(entry);
@@ -101,6 +109,7 @@ std::unordered_set<ResourceID> CFilesystemList::getFilteredFiles(std::function<b
 bool CFilesystemList::createResource(std::string filename, bool update)
 {
 	logGlobal->traceStream()<< "Creating " << filename;
+	boost::shared_lock<boost::shared_mutex> lock(mx);
 	for (auto & loader : boost::adaptors::reverse(loaders))
 	{
 		if (writeableLoaders.count(loader.get()) != 0                       // writeable,
@@ -109,7 +118,7 @@ bool CFilesystemList::createResource(std::string filename, bool update)
 			// Check if resource was created successfully. Possible reasons for this to fail
 			// a) loader failed to create resource (e.g. read-only FS)
 			// b) in update mode, call with filename that does not exists
-			assert(load(ResourceID(filename)));
+			assert(loader->existsResource(ResourceID(filename)));
 
 			logGlobal->traceStream()<< "Resource created successfully";
 			return true;
@@ -123,6 +132,7 @@ std::vector<const ISimpleResourceLoader *> CFilesystemList::getResourcesWithName
 {
 	std::vector<const ISimpleResourceLoader *> ret;
 
+	boost::shared_lock<boost::shared_mutex> lock(mx);
 	for (auto & loader : loaders)
 		boost::range::copy(loader->getResourcesWithName(resourceName), std::back_inserter(ret));
 
@@ -131,6 +141,7 @@ std::vector<const ISimpleResourceLoader *> CFilesystemList::getResourcesWithName
 
 void CFilesystemList::addLoader(ISimpleResourceLoader * loader, bool writeable)
 {
+	boost::unique_lock<boost::shared_mutex> lock(mx);
 	loaders.push_back(std::unique_ptr<ISimpleResourceLoader>(loader));
 	if (writeable)
 		writeableLoaders.insert(loader);
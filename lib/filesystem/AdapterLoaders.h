@@ -58,6 +58,8 @@ class DLL_LINKAGE CFilesystemList : public ISimpleResourceLoader
 
 	std::set<ISimpleResourceLoader *> writeableLoaders;
 
+	mutable boost::shared_mutex mx; //loaders may be added while resources are loaded by other threads
+
 	//FIXME: this is only compile fix, should be removed in the end
 	CFilesystemList(CFilesystemList &) 
     { 
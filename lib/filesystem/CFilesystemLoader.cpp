@@ -16,6 +16,7 @@ CFilesystemLoader::CFilesystemLoader(std::string _mountPoint, bfs::path baseDire
 
 std::unique_ptr<CInputStream> CFilesystemLoader::load(const ResourceID & resourceName) const
 {
+	boost::shared_lock<boost::shared_mutex> lock(fileListMx);
 	assert(fileList.count(resourceName));
 
 	std::unique_ptr<CInputStream> stream(new CFileInputStream(baseDirectory / fileList.at(resourceName)));
@@ -24,6 +25,7 @@ std::unique_ptr<CInputStream> CFilesystemLoader::load(const ResourceID & resourc
 
 bool CFilesystemLoader::existsResource(const ResourceID & resourceName) const
 {
+	boost::shared_lock<boost::shared_mutex> lock(fileListMx);
 	return fileList.count(resourceName);
 }
 
@@ -34,7 +36,8 @@ std::string CFilesystemLoader::getMountPoint() const
 
 boost::optional<std::string> CFilesystemLoader::getResourceName(const ResourceID & resourceName) const
 {
-	assert(existsResource(resourceName));
+	boost::shared_lock<boost::shared_mutex> lock(fileListMx);
+	assert(fileList.count(resourceName));
 
 	return (baseDirectory / fileList.at(resourceName)).string();
 }
@@ -43,6 +46,7 @@ std::unordered_set<ResourceID> CFilesystemLoader::getFilteredFiles(std::function
 {
 	std::unordered_set<ResourceID> foundID;
 
+	boost::shared_lock<boost::shared_mutex> lock(fileListMx);
 	for (auto & file : fileList)
 	{
 		if (filter(file.first))
@@ -55,6 +59,7 @@ bool CFilesystemLoader::createResource(std::string filename, bool update)
 {
 	ResourceID resID(filename);
 
+	boost::unique_lock<boost::shared_mutex> lock(fileListMx);
 	if (fileList.find(resID) != fileList.end())
 		return true;
 
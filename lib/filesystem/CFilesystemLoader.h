@@ -53,6 +53,9 @@ private:
 	*/
 	std::unordered_map<ResourceID, boost::filesystem::path> fileList;
 
+	/** Guards fileList, new files can be created while other threads load resources */
+	mutable boost::shared_mutex fileListMx;
+
 	/**
 	 * Returns a list of pathnames denoting the files in the directory denoted by this pathname.
 	 *
@@ -15,6 +15,7 @@
 #include "../CStopWatch.h"
 
 std::map<std::string, ISimpleResourceLoader*> CResourceHandler::knownLoaders = std::map<std::string, ISimpleResourceLoader*>();
+boost::shared_mutex CResourceHandler::knownLoadersMx;
 
 CFilesystemGenerator::CFilesystemGenerator(std::string prefix):
 	filesystem(new CFilesystemList()),
@@ -111,6 +112,7 @@ void CFilesystemGenerator::loadJsonMap(const std::string &mountPoint, const Json
 
 void CResourceHandler::clear()
 {
+	boost::unique_lock<boost::shared_mutex> lock(knownLoadersMx);
 	delete knownLoaders["root"];
 }
 
@@ -166,13 +168,16 @@ void CResourceHandler::initialize()
 	//    |-saves
 	//    |-config
 
-	knownLoaders["root"] = new CFilesystemList();
-	knownLoaders["saves"] = new CFilesystemLoader("SAVES/", VCMIDirs::get().userSavePath());
-	knownLoaders["config"] = new CFilesystemLoader("CONFIG/", VCMIDirs::get().userConfigPath());
-
 	auto localFS = new CFilesystemList();
-	localFS->addLoader(knownLoaders["saves"], true);
-	localFS->addLoader(knownLoaders["config"], true);
+	{
+		boost::unique_lock<boost::shared_mutex> lock(knownLoadersMx);
+		knownLoaders["root"] = new CFilesystemList();
+		knownLoaders["saves"] = new CFilesystemLoader("SAVES/", VCMIDirs::get().userSavePath());
+		knownLoaders["config"] = new CFilesystemLoader("CONFIG/", VCMIDirs::get().userConfigPath());
+
+		localFS->addLoader(knownLoaders["saves"], true);
+		localFS->addLoader(knownLoaders["config"], true);
+	}
 
 	addFilesystem("root", "initial", createInitial());
 	addFilesystem("root", "data", new CFilesystemList());
@@ -186,6 +191,7 @@ ISimpleResourceLoader * CResourceHandler::get()
 
 ISimpleResourceLoader * CResourceHandler::get(std::string identifier)
 {
+	boost::shared_lock<boost::shared_mutex> lock(knownLoadersMx);
 	return knownLoaders.at(identifier);
 }
 
@@ -200,6 +206,7 @@ void CResourceHandler::load(const std::string &fsConfigURI)
 
 void CResourceHandler::addFilesystem(const std::string & parent, const std::string & identifier, ISimpleResourceLoader * loader)
 {
+	boost::unique_lock<boost::shared_mutex> lock(knownLoadersMx);
 	assert(knownLoaders.count(identifier) == 0);
 
 	auto list = dynamic_cast<CFilesystemList *>(knownLoaders.at(parent));
@@ -107,4 +107,5 @@ public:
 private:
 	/** Instance of resource loader */
 	static std::map<std::string, ISimpleResourceLoader*> knownLoaders;
+	static boost::shared_mutex knownLoadersMx;
 };
@@ -132,11 +132,11 @@ Obj TerrainTile::topVisitableId(bool excludeTop) const
 
 CGObjectInstance * TerrainTile::topVisitableObj(bool excludeTop) const
 {
-	auto visitableObj = visitableObjects;
-	if(excludeTop && visitableObj.size())
-		visitableObj.pop_back();
+	size_t count = visitableObjects.size();
+	if(excludeTop && count)
+		count--;
 
-	return visitableObj.size() ? visitableObj.back() : nullptr;
+	return count ? visitableObjects[count - 1] : nullptr;
 }
 
 bool TerrainTile::isCoastal() const
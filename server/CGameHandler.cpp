@@ -26,6 +26,7 @@
 #include "CVCMIServer.h"
 #include "../lib/CCreatureSet.h"
 #include "../lib/CThreadHelper.h"
+#include "../lib/CProfiler.h"
 #include "../lib/GameConstants.h"
 #include "../lib/registerTypes/RegisterTypes.h"
 
@@ -1087,12 +1088,14 @@ CGameHandler::CGameHandler(void)
 	registerTypesServerPacks(*applier);
 	visitObjectAfterVictory = false;
 	queries.gh = this;
+	saveWriter = nullptr;
 	
 	spellEnv = new ServerSpellCastEnvironment(this);
 }
 
 CGameHandler::~CGameHandler(void)
 {
+	finishSaving();
 	delete spellEnv;
 	delete applier;
 	applier = nullptr;
@@ -1168,6 +1171,7 @@ void CGameHandler::setPortalDwelling(const CGTownInstance * town, bool forced=fa
 
 void CGameHandler::newTurn()
 {
+	PROFILE_ZONE("CGameHandler::newTurn");
     logGlobal->traceStream() << "Turn " << gs->day+1;
 	NewTurn n;
 	n.specialWeek = NewTurn::NO_ACTION;
@@ -2211,10 +2215,24 @@ void CGameHandler::heroExchange(ObjectInstanceID hero1, ObjectInstanceID hero2)
 void CGameHandler::sendToAllClients( CPackForClient * info )
 {
     logGlobal->traceStream() << "Sending to all clients a package of type " << typeid(*info).name();
+
+	//without smart pointers serialization result doesn't depend on what was sent before, so pack is the same for every client
+	std::shared_ptr<const std::vector<ui8>> frame;
 	for(auto & elem : conns)
 	{
 		boost::unique_lock<boost::mutex> lock(*(elem)->wmx);
-		*elem << info;
+		if(elem->oser.smartPointerSerialization)
+		{
+			*elem << info;
+			continue;
+		}
+
+		if(!frame)
+		{
+			elem->oser << info;
+			frame = elem->takeFrame();
+		}
+		elem->sendFrame(frame);
 	}
 }
 
@@ -2256,6 +2274,7 @@ void CGameHandler::sendAndApply( NewStructures * info )
 
 void CGameHandler::save(const std::string & filename )
 {
+	PROFILE_ZONE("CGameHandler::save");
     logGlobal->infoStream() << "Saving to " << filename;
 	CFileInfo info(filename);
 	//CResourceHandler::get("local")->createResource(info.getStem() + ".vlgm1");
@@ -2277,13 +2296,27 @@ void CGameHandler::save(const std::string & filename )
 // 			saveCommonState(save);
 // 		}
 
+		//previous save may still be written, possibly to the same file
+		finishSaving();
+
+		//serialize to memory while game state is consistent, file is written in background
+		auto save = std::make_shared<CSaveFile>(*CResourceHandler::get("local")->getResourceName(ResourceID(info.getStem(), EResType::SERVER_SAVEGAME)), true);
+		saveCommonState(*save);
+		logGlobal->infoStream() << "Saving server state";
+		*save << *this;
+
+		saveWriter = new boost::thread([save, filename]
 		{
-			CSaveFile save(*CResourceHandler::get("local")->getResourceName(ResourceID(info.getStem(), EResType::SERVER_SAVEGAME)));
-			saveCommonState(save);
-            logGlobal->infoStream() << "Saving server state";
-			save << *this;
-		}
-        logGlobal->infoStream() << "Game has been successfully saved!";
+			try
+			{
+				save->writeDeferred();
+				logGlobal->infoStream() << "Game has been saved as " << filename;
+			}
+			catch(std::exception &e)
+			{
+				logGlobal->errorStream() << "Failed to save game: " << e.what();
+			}
+		});
 	}
 	catch(std::exception &e)
 	{
@@ -2291,9 +2324,20 @@ void CGameHandler::save(const std::string & filename )
 	}
 }
 
+void CGameHandler::finishSaving()
+{
+	if(saveWriter)
+	{
+		saveWriter->join();
+		delete saveWriter;
+		saveWriter = nullptr;
+	}
+}
+
 void CGameHandler::close()
 {
     logGlobal->infoStream() << "We have been requested to close.";
+	finishSaving();
 
 	if(gs->initialOpts->mode == StartInfo::DUEL)
 	{
@@ -5720,7 +5764,11 @@ void CGameHandler::duelFinished()
 		logGlobal->errorStream() << "Cannot open to write " << cmdLineOptions["resultsFile"].as<std::string>();
 	}
 
-	CSaveFile resultFile("result.vdrst");
+	//with results file given, binary result goes next to it, so duels played at once don't overwrite each other
+	const auto & resultsOption = cmdLineOptions["resultsFile"];
+	const std::string resultPath = resultsOption.defaulted() ? "result.vdrst"
+		: boost::filesystem::path(resultsOption.as<std::string>()).replace_extension(".vdrst").string();
+	CSaveFile resultFile(resultPath);
 	resultFile << *battleResult.data;
 
 	BattleResultsApplied resultsApplied;
@@ -98,6 +98,9 @@ public:
 	ui32 QID;
 	Queries queries;
 
+	boost::thread *saveWriter; //writes the last save to disk, so game doesn't wait for it
+	void finishSaving(); //waits until the last save is on disk
+
 	//TODO get rid of cfunctionlist (or similar) and use serialziable callback structure
 	std::map<ui32, CFunctionList<void(ui32)> > callbacks; //query id => callback function - for selection and yes/no dialogs
 
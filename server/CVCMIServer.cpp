@@ -29,6 +29,7 @@
 #include "../lib/logging/CBasicLogConfigurator.h"
 #include "../lib/CConfigHandler.h"
 #include "../lib/ScopeGuard.h"
+#include "../lib/CProfiler.h"
 
 #include "../lib/UnlockGuard.h"
 
@@ -396,16 +397,17 @@ void CVCMIServer::start()
 #ifndef VCMI_ANDROID
 	ServerReady *sr = nullptr;
 	intpr::mapped_region *mr;
+	const std::string memoryName = serverReadyMemoryName(boost::lexical_cast<std::string>(port));
 	try
 	{
-		intpr::shared_memory_object smo(intpr::open_only,"vcmi_memory",intpr::read_write);
+		intpr::shared_memory_object smo(intpr::open_only,memoryName.c_str(),intpr::read_write);
 		smo.truncate(sizeof(ServerReady));
 		mr = new intpr::mapped_region(smo,intpr::read_write);
 		sr = reinterpret_cast<ServerReady*>(mr->get_address());
 	}
 	catch(...)
 	{
-		intpr::shared_memory_object smo(intpr::create_only,"vcmi_memory",intpr::read_write);
+		intpr::shared_memory_object smo(intpr::create_only,memoryName.c_str(),intpr::read_write);
 		smo.truncate(sizeof(ServerReady));
 		mr = new intpr::mapped_region(smo,intpr::read_write);
 		sr = new(mr->get_address())ServerReady();
@@ -523,7 +525,8 @@ static void handleCommandOptions(int argc, char *argv[])
 		("help,h", "display help and exit")
 		("version,v", "display version information and exit")
 		("port", po::value<int>()->default_value(3030), "port at which server will listen to connections from client")
-		("resultsFile", po::value<std::string>()->default_value("./results.txt"), "file to which the battle result will be appended. Used only in the DUEL mode.");
+		("resultsFile", po::value<std::string>()->default_value("./results.txt"), "file to which the battle result will be appended, serialized result is written next to it with .vdrst extension. Used only in the DUEL mode.")
+		("profile", "records timeline of startup and turns to VCMI_Server_profile.json in Chrome trace format");
 
 	if(argc > 1)
 	{
@@ -599,6 +602,8 @@ int main(int argc, char** argv)
 	logConfig.configureDefault();
 
 	handleCommandOptions(argc, argv);
+	if(cmdLineOptions.count("profile"))
+		CProfiler::start(VCMIDirs::get().userCachePath() / "VCMI_Server_profile.json");
 	port = cmdLineOptions["port"].as<int>();
 	logNetwork->infoStream() << "Port " << port << " will be used.";
 
@@ -46,8 +46,7 @@ CGameState* CPackForServer::GS(CGameHandler *gh)
 
 bool SaveGame::applyGh( CGameHandler *gh )
 {
-	gh->save(fname);
-	logGlobal->infoStream() << "Game has been saved as " + fname;
+	gh->save(fname); //logs when the save is on disk
 	return true;
 }
 
@@ -0,0 +1,150 @@
+/*
+ * BattleHexTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include <boost/test/unit_test.hpp>
+
+#include "../lib/BattleHex.h"
+#include "../lib/CStopWatch.h"
+#include "CVcmiTestConfig.h"
+
+namespace
+{
+	//moves hex by one hex in given direction
+	//0 - left top, 1 - right top, 2 - right, 3 - right bottom, 4 - left bottom, 5 - left
+	std::pair<int, int> gotoDir(std::pair<int, int> xy, int direction)
+	{
+		const int x = xy.first, y = xy.second;
+		switch(direction)
+		{
+		case 0:
+			return std::make_pair((y%2) ? x-1 : x, y-1);
+		case 1:
+			return std::make_pair((y%2) ? x : x+1, y-1);
+		case 2:
+			return std::make_pair(x+1, y);
+		case 3:
+			return std::make_pair((y%2) ? x : x+1, y+1);
+		case 4:
+			return std::make_pair((y%2) ? x-1 : x, y+1);
+		default:
+			return std::make_pair(x-1, y);
+		}
+	}
+
+	// Ring walk that spell ranges used before distance table, hexes in distance between low and high from center
+	std::set<si16> ringWalk(BattleHex center, int low, int high)
+	{
+		std::set<si16> ret;
+		if(low == 0)
+			ret.insert(center);
+
+		std::pair<int, int> mainPointForLayer[6]; //A, B, C, D, E, F points
+		for(auto & elem : mainPointForLayer)
+			elem = std::pair<int, int>(center.getX(), center.getY());
+
+		for(int it = 1; it <= high; ++it) //it - distance to the center
+		{
+			for(int b = 0; b < 6; ++b)
+				mainPointForLayer[b] = gotoDir(mainPointForLayer[b], b);
+
+			if(it >= low)
+			{
+				//adding lines (A-b, B-c, C-d, etc)
+				for(int v = 0; v < 6; ++v)
+				{
+					std::pair<int, int> curHex = mainPointForLayer[v];
+					for(int h = 0; h < it; ++h)
+					{
+						if(curHex.first >= 0 && curHex.first < GameConstants::BFIELD_WIDTH && curHex.second >= 0 && curHex.second < GameConstants::BFIELD_HEIGHT)
+							ret.insert(curHex.first + curHex.second * GameConstants::BFIELD_WIDTH);
+						curHex = gotoDir(curHex, (v+2)%6);
+					}
+				}
+			}
+		}
+		return ret;
+	}
+
+	const int MAX_RANGE = GameConstants::BFIELD_WIDTH + GameConstants::BFIELD_HEIGHT; //more than any distance on battlefield
+}
+
+BOOST_AUTO_TEST_CASE(BattleHex_DistanceMatchesRingWalk)
+{
+	for(si16 center = 0; center < GameConstants::BFIELD_SIZE; center++)
+	{
+		int found = 0;
+		for(int distance = 0; distance <= MAX_RANGE; distance++)
+		{
+			for(si16 hex : ringWalk(center, distance, distance))
+			{
+				BOOST_REQUIRE_EQUAL((int)BattleHex::getDistance(center, hex), distance);
+				found++;
+			}
+		}
+		BOOST_REQUIRE_EQUAL(found, GameConstants::BFIELD_SIZE);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(BattleHex_GetInRangeMatchesRingWalk)
+{
+	for(si16 center = 0; center < GameConstants::BFIELD_SIZE; center++)
+	{
+		// ring walk visits each ring independently of the requested range, so every range is a union of rings
+		std::vector<std::set<si16> > rings;
+		for(int distance = 0; distance <= MAX_RANGE; distance++)
+			rings.push_back(ringWalk(center, distance, distance));
+
+		for(int low = 0; low <= MAX_RANGE; low++)
+		{
+			std::set<si16> expected;
+			for(int high = low; high <= MAX_RANGE; high++)
+			{
+				expected.insert(rings[high].begin(), rings[high].end());
+
+				const std::vector<BattleHex> result = BattleHex::getInRange(center, low, high);
+				BOOST_REQUIRE(std::set<si16>(result.begin(), result.end()) == expected);
+				BOOST_REQUIRE_EQUAL(result.size(), expected.size());
+				if(high - low < 4) //direct walk for short ranges too, it's slow for all of them
+					BOOST_REQUIRE(ringWalk(center, low, high) == expected);
+			}
+		}
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(Benchmark)
+
+BOOST_AUTO_TEST_CASE(BattleHex_DistanceBenchmark)
+{
+	if(!CVcmiTestConfig::benchmarksEnabled())
+		return;
+
+	// calculateDistance is what getDistance computed before distance table, sums keep both loops from being optimised away
+	const int REPEATS = 200;
+	si64 tableSum = 0, formulaSum = 0;
+	CStopWatch timer;
+	for(int i = 0; i < REPEATS; i++)
+		for(si16 from = 0; from < GameConstants::BFIELD_SIZE; from++)
+			for(si16 to = 0; to < GameConstants::BFIELD_SIZE; to++)
+				tableSum += BattleHex::getDistance(from, to);
+	const si64 tableTime = timer.getDiff();
+
+	for(int i = 0; i < REPEATS; i++)
+		for(si16 from = 0; from < GameConstants::BFIELD_SIZE; from++)
+			for(si16 to = 0; to < GameConstants::BFIELD_SIZE; to++)
+				formulaSum += BattleHex::calculateDistance(from, to);
+	const si64 formulaTime = timer.getDiff();
+
+	BOOST_CHECK_EQUAL(tableSum, formulaSum);
+	logGlobal->infoStream() << boost::format("%d distances: table %d ms, formula %d ms")
+		% (REPEATS * GameConstants::BFIELD_SIZE * GameConstants::BFIELD_SIZE) % tableTime % formulaTime;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,279 @@
+/*
+ * BattleSearchTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include <boost/test/unit_test.hpp>
+
+#include "../AI/BattleAI/BattleSearch.h"
+
+namespace
+{
+	SimulatedStack makeStack(bool attackerOwned, int speed, BattleHex position, int count = 10, int maxHealth = 10)
+	{
+		SimulatedStack ret;
+		ret.stack = nullptr;
+		ret.attackerOwned = attackerOwned;
+		ret.shooter = false;
+		ret.blocksRetaliation = false;
+		ret.doubleWide = false;
+		ret.speed = speed;
+		ret.count = count;
+		ret.firstHPleft = maxHealth;
+		ret.maxHealth = maxHealth;
+		ret.value = 100;
+		ret.shots = 0;
+		ret.retaliations = ret.retaliationsPerRound = 1;
+		ret.moved = false;
+		ret.position = position;
+		return ret;
+	}
+
+	//every creature deals the same damage to every enemy
+	shared_ptr<SimulatedDamage> makeDamage(const std::vector<SimulatedStack> &stacks, double perCreature)
+	{
+		auto ret = std::make_shared<SimulatedDamage>();
+		ret->stacks = stacks.size();
+		ret->melee.assign(stacks.size() * stacks.size(), perCreature);
+		ret->ranged.assign(stacks.size() * stacks.size(), perCreature);
+		return ret;
+	}
+
+	SimulatedBattle makeBattle(const std::vector<SimulatedStack> &stacks, double perCreature = 1)
+	{
+		SimulatedBattle ret;
+		ret.stacks = stacks;
+		ret.damage = makeDamage(stacks, perCreature);
+		ret.nextStack();
+		return ret;
+	}
+
+	// Random battle where defenders mirror attackers, so neither side has better army or position
+	SimulatedBattle mirroredBattle(std::mt19937 &gen)
+	{
+		std::uniform_int_distribution<int> stackCount(1, 3), speed(3, 9), count(1, 20), health(5, 30), value(50, 500), percent(0, 99),
+			column(1, 3), row(0, GameConstants::BFIELD_HEIGHT - 1), damage(1, 8);
+
+		SimulatedBattle ret;
+		std::set<BattleHex> used;
+		for(int i = stackCount(gen); i > 0; i--)
+		{
+			BattleHex position;
+			do
+			{
+				position = BattleHex(column(gen), row(gen));
+			} while(vstd::contains(used, position));
+			used.insert(position);
+
+			SimulatedStack s = makeStack(true, speed(gen), position, count(gen), health(gen));
+			s.value = value(gen);
+			s.shooter = percent(gen) < 30;
+			s.shots = s.shooter ? 12 : 0;
+			ret.stacks.push_back(s);
+		}
+
+		const int half = ret.stacks.size();
+		for(int i = 0; i < half; i++)
+		{
+			SimulatedStack s = ret.stacks[i];
+			s.attackerOwned = false;
+			s.position = BattleHex(GameConstants::BFIELD_WIDTH - 1 - s.position.getX(), (int)s.position.getY());
+			ret.stacks.push_back(s);
+		}
+
+		auto dmg = makeDamage(ret.stacks, 0);
+		for(int i = 0; i < half; i++)
+		{
+			for(int j = 0; j < half; j++)
+			{
+				const int melee = damage(gen), ranged = damage(gen);
+				dmg->melee[i * dmg->stacks + half + j] = dmg->melee[(half + i) * dmg->stacks + j] = melee;
+				dmg->ranged[i * dmg->stacks + half + j] = dmg->ranged[(half + i) * dmg->stacks + j] = ranged;
+			}
+		}
+		ret.damage = dmg;
+		ret.nextStack();
+		return ret;
+	}
+
+	// Minimax without pruning, kept as reference
+	int plainMinimax(const SimulatedBattle &battle, int depth, bool side)
+	{
+		if(depth == 0 || battle.finished())
+			return battle.evaluate(side);
+
+		std::vector<int> values;
+		for(auto &action : battle.possibleActions())
+		{
+			SimulatedBattle next = battle;
+			next.apply(action);
+			values.push_back(plainMinimax(next, depth - 1, side));
+		}
+		const bool maximizing = battle.stacks[battle.active].attackerOwned == side;
+		return maximizing ? *boost::max_element(values) : *boost::min_element(values);
+	}
+
+	//plays battle out, attackers search given number of actions ahead and defenders the other; returns evaluation for attackers
+	int playBattle(SimulatedBattle battle, int attackerDepth, int defenderDepth)
+	{
+		for(int i = 0; i < 100 && !battle.finished(); i++)
+		{
+			const auto actions = battle.possibleActions();
+			const int depth = battle.stacks[battle.active].attackerOwned ? attackerDepth : defenderDepth;
+			battle.apply(actions[BattleSearch::chooseAction(battle, actions, 0, depth)]);
+		}
+		return battle.evaluate(true);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(BattleSearch_TakeDamage)
+{
+	SimulatedStack s = makeStack(true, 5, BattleHex(1, 1), 10, 10);
+	s.takeDamage(15);
+	BOOST_CHECK_EQUAL(s.count, 9);
+	BOOST_CHECK_EQUAL(s.firstHPleft, 5);
+	BOOST_CHECK_EQUAL(s.health(), 85);
+
+	s.takeDamage(5);
+	BOOST_CHECK_EQUAL(s.count, 8);
+	BOOST_CHECK_EQUAL(s.firstHPleft, 10);
+
+	s.takeDamage(0);
+	BOOST_CHECK_EQUAL(s.count, 8);
+	BOOST_CHECK_EQUAL(s.health(), 80);
+
+	s.takeDamage(1000);
+	BOOST_CHECK_EQUAL(s.count, 0);
+	BOOST_CHECK_EQUAL(s.firstHPleft, 0);
+	BOOST_CHECK_EQUAL(s.health(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(BattleSearch_NextStack)
+{
+	std::vector<SimulatedStack> stacks;
+	stacks.push_back(makeStack(true, 5, BattleHex(1, 1)));
+	stacks.push_back(makeStack(true, 12, BattleHex(1, 3), 0)); //dead
+	stacks.push_back(makeStack(false, 8, BattleHex(15, 1)));
+	stacks.push_back(makeStack(false, 6, BattleHex(15, 3)));
+	SimulatedBattle battle = makeBattle(stacks);
+	BOOST_CHECK_EQUAL(battle.active, 2);
+
+	battle.stacks[2].moved = true;
+	battle.nextStack();
+	BOOST_CHECK_EQUAL(battle.active, 3);
+
+	battle.stacks[3].moved = true;
+	battle.nextStack();
+	BOOST_CHECK_EQUAL(battle.active, 0);
+
+	//new round restores retaliations
+	battle.stacks[0].moved = true;
+	battle.stacks[2].retaliations = 0;
+	battle.nextStack();
+	BOOST_CHECK_EQUAL(battle.active, 2);
+	BOOST_CHECK_EQUAL(battle.stacks[2].retaliations, 1);
+	for(auto &s : battle.stacks)
+		BOOST_CHECK(!s.moved);
+}
+
+BOOST_AUTO_TEST_CASE(BattleSearch_MeleeFromNearestFreeTile)
+{
+	std::vector<SimulatedStack> stacks;
+	stacks.push_back(makeStack(true, 10, BattleHex(3, 5)));
+	stacks.push_back(makeStack(true, 1, BattleHex(5, 5)));
+	stacks.push_back(makeStack(false, 1, BattleHex(6, 5)));
+	SimulatedBattle battle = makeBattle(stacks);
+
+	const auto actions = battle.possibleActions();
+	BOOST_REQUIRE_EQUAL(actions.size(), 1);
+	BOOST_CHECK_EQUAL(actions[0].target, 2);
+	BOOST_CHECK(!actions[0].shooting);
+	BOOST_CHECK(actions[0].tile != BattleHex(5, 5)); //occupied by ally
+	BOOST_CHECK_EQUAL(BattleHex::getDistance(actions[0].tile, BattleHex(6, 5)), 1);
+	BOOST_CHECK_EQUAL(BattleHex::getDistance(actions[0].tile, BattleHex(3, 5)), 3);
+}
+
+BOOST_AUTO_TEST_CASE(BattleSearch_MoveTowardsEnemyOutOfReach)
+{
+	std::vector<SimulatedStack> stacks;
+	stacks.push_back(makeStack(true, 2, BattleHex(1, 5)));
+	stacks.push_back(makeStack(false, 1, BattleHex(15, 5)));
+	SimulatedBattle battle = makeBattle(stacks);
+
+	const auto actions = battle.possibleActions();
+	BOOST_REQUIRE_EQUAL(actions.size(), 1);
+	BOOST_CHECK_EQUAL(actions[0].target, -1);
+	BOOST_CHECK_EQUAL(BattleHex::getDistance(actions[0].tile, BattleHex(15, 5)), 12);
+}
+
+BOOST_AUTO_TEST_CASE(BattleSearch_ShooterBlockedByAdjacentEnemy)
+{
+	std::vector<SimulatedStack> stacks;
+	stacks.push_back(makeStack(true, 5, BattleHex(1, 5)));
+	stacks.push_back(makeStack(false, 1, BattleHex(15, 5)));
+	stacks[0].shooter = true;
+	stacks[0].shots = 1;
+	SimulatedBattle battle = makeBattle(stacks);
+
+	auto actions = battle.possibleActions();
+	BOOST_REQUIRE_EQUAL(actions.size(), 1);
+	BOOST_CHECK(actions[0].shooting);
+	BOOST_CHECK(actions[0].tile == BattleHex(1, 5));
+
+	battle.apply(actions[0]);
+	BOOST_CHECK_EQUAL(battle.stacks[0].shots, 0);
+	BOOST_CHECK_EQUAL(battle.stacks[1].health(), 90);
+	BOOST_CHECK_EQUAL(battle.stacks[0].health(), 100); //no retaliation for shots
+
+	battle.stacks[1].position = BattleHex(2, 5);
+	battle.stacks[0].shots = 1;
+	battle.active = 0;
+	actions = battle.possibleActions();
+	BOOST_REQUIRE_EQUAL(actions.size(), 1);
+	BOOST_CHECK(!actions[0].shooting);
+}
+
+BOOST_AUTO_TEST_CASE(BattleSearch_AlphaBetaMatchesPlainMinimax)
+{
+	std::mt19937 gen(11);
+	for(int i = 0; i < 200; i++)
+	{
+		const SimulatedBattle battle = mirroredBattle(gen);
+		for(int depth = 0; depth <= 3; depth++)
+		{
+			for(bool side : {true, false})
+			{
+				bool timedOut = false;
+				const int value = BattleSearch::minimax(battle, depth, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(),
+					side, BattleSearch::TClock::time_point::max(), timedOut);
+				BOOST_REQUIRE(!timedOut);
+				BOOST_REQUIRE_EQUAL(value, plainMinimax(battle, depth, side));
+			}
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(BattleSearch_SearchBeatsGreedy)
+{
+	// same battle is played twice with sides swapped, greedy player picks best action one action ahead like bestAction() does
+	std::mt19937 gen(13);
+	int searchWins = 0, greedyWins = 0;
+	for(int i = 0; i < 100; i++)
+	{
+		const SimulatedBattle battle = mirroredBattle(gen);
+		const int searchAttacking = playBattle(battle, 3, 1);
+		const int greedyAttacking = playBattle(battle, 1, 3);
+		if(searchAttacking > greedyAttacking)
+			searchWins++;
+		else if(searchAttacking < greedyAttacking)
+			greedyWins++;
+	}
+	BOOST_TEST_MESSAGE(boost::format("Search won %d mirrored battles, greedy won %d") % searchWins % greedyWins);
+	BOOST_CHECK_GE(searchWins, greedyWins);
+}
@@ -0,0 +1,173 @@
+/*
+ * CBattleInfoCallbackTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include <boost/test/unit_test.hpp>
+
+#include "../lib/CBattleCallback.h"
+#include "../lib/CStopWatch.h"
+#include "CVcmiTestConfig.h"
+
+namespace
+{
+	// neighbours as BattleHex::neighbouringTiles computed them before there was a table
+	std::vector<BattleHex> allocatingNeighbours(BattleHex hex)
+	{
+		std::vector<BattleHex> ret;
+		const int WN = GameConstants::BFIELD_WIDTH;
+		BattleHex::checkAndPush(hex - ( (hex/WN)%2 ? WN+1 : WN ), ret);
+		BattleHex::checkAndPush(hex + 1, ret);
+		BattleHex::checkAndPush(hex + ( (hex/WN)%2 ? WN : WN+1 ), ret);
+		BattleHex::checkAndPush(hex + ( (hex/WN)%2 ? WN-1 : WN ), ret);
+		BattleHex::checkAndPush(hex - 1, ret);
+		BattleHex::checkAndPush(hex - ( (hex/WN)%2 ? WN : WN-1 ), ret);
+		return ret;
+	}
+
+	const std::vector<BattleHex> & tableNeighbours(BattleHex hex)
+	{
+		return hex.neighbouringTiles();
+	}
+
+	// makeBFS used before it walked a mask of unvisited hexes, kept as reference
+	// with allocatingNeighbours it is makeBFS from before neighbour table
+	template <typename Neighbours>
+	ReachabilityInfo queueBFS(const AccessibilityInfo & accessibility, const ReachabilityInfo::Parameters & params, const TBattleHexMask & quicksands, Neighbours neighbours)
+	{
+		ReachabilityInfo ret;
+		ret.accessibility = accessibility;
+		ret.params = params;
+
+		std::queue<BattleHex> hexq;
+		hexq.push(params.startPosition);
+		ret.distances[params.startPosition] = 0;
+
+		while(!hexq.empty())
+		{
+			const BattleHex curHex = hexq.front();
+			hexq.pop();
+
+			if(curHex != params.startPosition && quicksands[curHex])
+				continue;
+
+			const int costToNeighbour = ret.distances[curHex] + 1;
+			for(BattleHex neighbour : neighbours(curHex))
+			{
+				if(accessibility.accessible(neighbour, params.doubleWide, params.attackerOwned) && costToNeighbour < ret.distances[neighbour])
+				{
+					hexq.push(neighbour);
+					ret.distances[neighbour] = costToNeighbour;
+					ret.predecessors[neighbour] = curHex;
+				}
+			}
+		}
+		return ret;
+	}
+
+	struct RandomBattlefield
+	{
+		AccessibilityInfo accessibility;
+		ReachabilityInfo::Parameters params;
+		TBattleHexMask quicksands;
+
+		RandomBattlefield(std::mt19937 & gen)
+		{
+			std::uniform_int_distribution<int> percent(0, 99), hex(0, GameConstants::BFIELD_SIZE - 1), count(0, 5);
+
+			for(auto & tile : accessibility)
+			{
+				const int roll = percent(gen);
+				if(roll < 70)
+					tile = EAccessibility::ACCESSIBLE;
+				else if(roll < 80)
+					tile = EAccessibility::ALIVE_STACK;
+				else if(roll < 90)
+					tile = EAccessibility::OBSTACLE;
+				else
+					tile = EAccessibility::GATE;
+			}
+			for(int i = count(gen); i > 0; i--)
+				quicksands.set(hex(gen));
+
+			params.startPosition = hex(gen);
+			params.attackerOwned = percent(gen) < 50;
+			params.doubleWide = percent(gen) < 50;
+		}
+	};
+}
+
+BOOST_AUTO_TEST_CASE(CBattleInfoCallback_MaskBFSMatchesQueueBFS)
+{
+	std::mt19937 gen(5);
+	for(int i = 0; i < 20000; i++)
+	{
+		const RandomBattlefield field(gen);
+		const ReachabilityInfo result = CBattleInfoCallback::makeBFS(field.accessibility, field.params, field.quicksands);
+		const ReachabilityInfo expected = queueBFS(field.accessibility, field.params, field.quicksands, tableNeighbours);
+
+		// hexes are visited in the same order, so even the chosen paths have to be the same
+		BOOST_REQUIRE(result.distances == expected.distances);
+		BOOST_REQUIRE(result.predecessors == expected.predecessors);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(Benchmark)
+
+BOOST_AUTO_TEST_CASE(CBattleInfoCallback_MakeBFSBenchmark)
+{
+	if(!CVcmiTestConfig::benchmarksEnabled())
+		return;
+
+	// timing is only logged, results of all searches are compared so none of them can be optimised away
+	std::mt19937 gen(7);
+	std::vector<RandomBattlefield> fields;
+	for(int i = 0; i < 1000; i++)
+		fields.push_back(RandomBattlefield(gen));
+
+	const int REPEATS = 20;
+	si64 maskSum = 0, queueSum = 0, allocatingSum = 0;
+	CStopWatch timer;
+	for(int i = 0; i < REPEATS; i++)
+	{
+		for(auto & field : fields)
+		{
+			const auto distances = CBattleInfoCallback::makeBFS(field.accessibility, field.params, field.quicksands).distances;
+			maskSum += std::accumulate(distances.begin(), distances.end(), si64(0));
+		}
+	}
+	const si64 maskTime = timer.getDiff();
+
+	for(int i = 0; i < REPEATS; i++)
+	{
+		for(auto & field : fields)
+		{
+			const auto distances = queueBFS(field.accessibility, field.params, field.quicksands, tableNeighbours).distances;
+			queueSum += std::accumulate(distances.begin(), distances.end(), si64(0));
+		}
+	}
+	const si64 queueTime = timer.getDiff();
+
+	for(int i = 0; i < REPEATS; i++)
+	{
+		for(auto & field : fields)
+		{
+			const auto distances = queueBFS(field.accessibility, field.params, field.quicksands, allocatingNeighbours).distances;
+			allocatingSum += std::accumulate(distances.begin(), distances.end(), si64(0));
+		}
+	}
+	const si64 allocatingTime = timer.getDiff();
+
+	BOOST_CHECK_EQUAL(maskSum, queueSum);
+	BOOST_CHECK_EQUAL(maskSum, allocatingSum);
+	logGlobal->infoStream() << boost::format("%d searches: makeBFS %d ms, queue BFS with neighbour table %d ms, with allocated neighbours %d ms")
+		% (REPEATS * fields.size()) % maskTime % queueTime % allocatingTime;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,150 @@
+/*
+ * CBonusSystemNodeTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include <boost/test/unit_test.hpp>
+
+#include "../lib/HeroBonus.h"
+#include "../lib/CStopWatch.h"
+#include "../lib/CThreadHelper.h"
+#include "CVcmiTestConfig.h"
+
+namespace
+{
+	// Global node, players, heroes and their stacks, each level with a few bonuses of its own like in a real game
+	struct BonusTree
+	{
+		std::vector<unique_ptr<CBonusSystemNode> > nodes; //parents before children
+		std::vector<const CBonusSystemNode *> stacks;
+
+		BonusTree()
+		{
+			auto addNode = [&](CBonusSystemNode * parent, int bonusCount) -> CBonusSystemNode *
+			{
+				nodes.push_back(make_unique<CBonusSystemNode>());
+				CBonusSystemNode * node = nodes.back().get();
+				if(parent)
+					node->attachTo(parent);
+				for(int i = 0; i < bonusCount; i++)
+				{
+					node->addNewBonus(new Bonus(Bonus::PERMANENT, Bonus::PRIMARY_SKILL, Bonus::OTHER, 1, i, i % 4));
+					node->addNewBonus(new Bonus(Bonus::PERMANENT, i % 2 ? Bonus::MORALE : Bonus::LUCK, Bonus::OTHER, 1, i));
+				}
+				return node;
+			};
+
+			CBonusSystemNode * global = addNode(nullptr, 10);
+			for(int player = 0; player < 4; player++)
+			{
+				CBonusSystemNode * playerNode = addNode(global, 2);
+				for(int hero = 0; hero < 8; hero++)
+				{
+					CBonusSystemNode * heroNode = addNode(playerNode, 8);
+					for(int stack = 0; stack < 7; stack++)
+					{
+						CBonusSystemNode * stackNode = addNode(heroNode, 1);
+						stackNode->addNewBonus(new Bonus(Bonus::PERMANENT, Bonus::STACKS_SPEED, Bonus::CREATURE_ABILITY, 5, stack));
+						stacks.push_back(stackNode);
+					}
+				}
+			}
+		}
+
+		~BonusTree()
+		{
+			while(!nodes.empty())
+				nodes.pop_back();
+		}
+	};
+
+	// Typical cached queries of battle and adventure AI, every thread goes over all stacks so they contend for the same nodes
+	si64 queryStacks(const BonusTree & tree, int repeats, boost::mutex * globalMx)
+	{
+		auto query = [](const CBonusSystemNode * stack) -> si64
+		{
+			return stack->valOfBonuses(Bonus::STACKS_SPEED)
+				+ stack->valOfBonuses(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK)
+				+ stack->MoraleVal() + stack->LuckVal()
+				+ stack->hasBonusOfType(Bonus::FLYING);
+		};
+
+		si64 sum = 0;
+		for(int i = 0; i < repeats; i++)
+		{
+			for(const CBonusSystemNode * stack : tree.stacks)
+			{
+				if(globalMx)
+				{
+					boost::unique_lock<boost::mutex> lock(*globalMx);
+					sum += query(stack);
+				}
+				else
+					sum += query(stack);
+			}
+		}
+		return sum;
+	}
+}
+
+// Copies are made when PlayerState or TeamState is put into a map, their bonuses must keep invalidating caches of the copy
+BOOST_AUTO_TEST_CASE(CBonusSystemNode_CopyOwnsItsBonusLists)
+{
+	CBonusSystemNode source;
+	BOOST_CHECK_EQUAL(source.valOfBonuses(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK), 0);
+
+	CBonusSystemNode copy(source), assigned;
+	assigned = source;
+	for(CBonusSystemNode * node : {&copy, &assigned})
+	{
+		BOOST_CHECK_EQUAL(node->valOfBonuses(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK), 0);
+		node->addNewBonus(new Bonus(Bonus::PERMANENT, Bonus::PRIMARY_SKILL, Bonus::OTHER, 2, 0, PrimarySkill::ATTACK));
+		BOOST_CHECK_EQUAL(node->valOfBonuses(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK), 2);
+	}
+	BOOST_CHECK_EQUAL(source.valOfBonuses(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK), 0);
+}
+
+BOOST_AUTO_TEST_SUITE(Benchmark)
+
+// Throughput of cached bonus queries for growing number of threads.
+// Global mutex taken around every query stands for the static mutex getAllBonuses used to take.
+BOOST_AUTO_TEST_CASE(CBonusSystemNode_ContentionBenchmark)
+{
+	if(!CVcmiTestConfig::benchmarksEnabled())
+		return;
+
+	const BonusTree tree;
+	const int REPEATS = 200;
+	const si64 expected = queryStacks(tree, 1, nullptr); //warms caches up
+	const int maxThreads = std::max(4, (int)boost::thread::hardware_concurrency());
+
+	for(int threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		for(bool globalLock : {false, true})
+		{
+			boost::mutex globalMx;
+			std::vector<si64> sums(threads);
+			std::vector<Task> tasks;
+			for(int i = 0; i < threads; i++)
+				tasks.push_back([&, i]{ sums[i] = queryStacks(tree, REPEATS, globalLock ? &globalMx : nullptr); });
+
+			CStopWatch timer;
+			CThreadHelper(&tasks, threads).run();
+			const si64 time = std::max<si64>(1, timer.getDiff());
+
+			for(si64 sum : sums)
+				BOOST_CHECK_EQUAL(sum, expected * REPEATS);
+			const si64 queries = (si64)threads * REPEATS * tree.stacks.size() * 5;
+			logGlobal->infoStream() << boost::format("%d threads, %s: %d queries in %d ms, %d queries per ms")
+				% threads % (globalLock ? "one global lock" : "per node locks") % queries % time % (queries / time);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,181 @@
+/*
+ * CConnectionTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include <boost/test/unit_test.hpp>
+
+#include <boost/asio.hpp>
+
+#include "../lib/Connection.h"
+#include "../lib/NetPacks.h"
+#include "../lib/registerTypes/RegisterTypes.h"
+#include "../lib/CStopWatch.h"
+#include "CVcmiTestConfig.h"
+
+namespace
+{
+	const int CLIENTS = 4;
+	const int PACKS = 20000;
+
+	// Writes to socket on every call, as CConnection::write did before data was sent in frames
+	class UnbufferedSocketWriter : public IBinaryWriter
+	{
+		TSocket & socket;
+	public:
+		COSer oser;
+
+		UnbufferedSocketWriter(TSocket & Socket)
+			: socket(Socket), oser(this)
+		{
+			registerTypes(oser);
+			oser.smartPointerSerialization = false;
+		}
+
+		int write(const void * data, unsigned size) override
+		{
+			return boost::asio::write(socket, boost::asio::buffer(data, size));
+		}
+	};
+
+	BattleStackAttacked makePack(int i)
+	{
+		BattleStackAttacked ret;
+		ret.stackAttacked = i % 14;
+		ret.attackerID = (i + 7) % 14;
+		ret.newAmount = 100 - i % 100;
+		ret.newHP = 10;
+		ret.killedAmount = 1;
+		ret.damageAmount = 10;
+		return ret;
+	}
+
+	// Server side of connections, what CGameHandler::sendToAllClients does for every pack
+	void sendFramed(std::vector<unique_ptr<CConnection> > & server)
+	{
+		for(int i = 0; i < PACKS; i++)
+		{
+			BattleStackAttacked pack = makePack(i);
+			CPackForClient * info = &pack;
+
+			std::shared_ptr<const std::vector<ui8> > frame;
+			for(auto & conn : server)
+			{
+				boost::unique_lock<boost::mutex> lock(*conn->wmx);
+				if(!frame)
+				{
+					conn->oser << info;
+					frame = conn->takeFrame();
+				}
+				conn->sendFrame(frame);
+			}
+		}
+	}
+
+	// Whole round trip of PACKS packs to CLIENTS connected clients through loopback, in ms
+	si64 framedThroughput()
+	{
+		boost::asio::io_service io;
+		TAcceptor acceptor(io, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+		const std::string port = boost::lexical_cast<std::string>(acceptor.local_endpoint().port());
+
+		std::vector<unique_ptr<CConnection> > server(CLIENTS), clients(CLIENTS);
+		for(int i = 0; i < CLIENTS; i++)
+		{
+			//handshake needs both sides, so client connects on its own thread
+			boost::thread connecting([&, i]{ clients[i] = make_unique<CConnection>("127.0.0.1", port, "benchmark client"); });
+			auto socketIo = new boost::asio::io_service; //connection deletes it
+			auto socket = new TSocket(*socketIo);
+			acceptor.accept(*socket);
+			server[i] = make_unique<CConnection>(socket, "benchmark server");
+			connecting.join();
+
+			//as in game, after pregame every client gets the same bytes
+			server[i]->disableSmartPointerSerialization();
+			clients[i]->disableSmartPointerSerialization();
+		}
+
+		CStopWatch timer;
+		boost::thread_group receiving;
+		for(auto & conn : clients)
+		{
+			CConnection * c = conn.get();
+			receiving.create_thread([c]
+			{
+				for(int i = 0; i < PACKS; i++)
+					delete c->retreivePack();
+			});
+		}
+		sendFramed(server);
+		receiving.join_all();
+		return timer.getDiff();
+	}
+
+	// Same packs written primitive by primitive to plain sockets, clients only count received bytes
+	si64 unbufferedThroughput()
+	{
+		boost::asio::io_service io;
+		TAcceptor acceptor(io, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+
+		std::vector<unique_ptr<TSocket> > server, clients;
+		for(int i = 0; i < CLIENTS; i++)
+		{
+			clients.push_back(make_unique<TSocket>(io));
+			clients.back()->connect(acceptor.local_endpoint());
+			server.push_back(make_unique<TSocket>(io));
+			acceptor.accept(*server.back());
+			server.back()->set_option(boost::asio::ip::tcp::no_delay(true));
+		}
+
+		CStopWatch timer;
+		boost::thread_group receiving;
+		for(auto & socket : clients)
+		{
+			TSocket * s = socket.get();
+			receiving.create_thread([s]
+			{
+				std::vector<ui8> buffer(64 * 1024);
+				boost::system::error_code ec;
+				while(!ec)
+					s->read_some(boost::asio::buffer(buffer), ec);
+			});
+		}
+
+		std::vector<unique_ptr<UnbufferedSocketWriter> > writers;
+		for(auto & socket : server)
+			writers.push_back(make_unique<UnbufferedSocketWriter>(*socket));
+		for(int i = 0; i < PACKS; i++)
+		{
+			BattleStackAttacked pack = makePack(i);
+			CPackForClient * info = &pack;
+			for(auto & writer : writers)
+				writer->oser << info;
+		}
+		for(auto & socket : server)
+			socket->shutdown(TSocket::shutdown_send);
+		receiving.join_all();
+		return timer.getDiff();
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(Benchmark)
+
+// Old reading side isn't simulated, its clients only drain sockets, so old time is rather underestimated
+BOOST_AUTO_TEST_CASE(CConnection_FramingBenchmark)
+{
+	if(!CVcmiTestConfig::benchmarksEnabled())
+		return;
+
+	const si64 framedTime = framedThroughput();
+	const si64 unbufferedTime = unbufferedThroughput();
+	logGlobal->infoStream() << boost::format("%d packs to %d clients over loopback: frames %d ms, write per primitive %d ms")
+		% PACKS % CLIENTS % framedTime % unbufferedTime;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
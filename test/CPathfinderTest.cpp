@@ -0,0 +1,181 @@
+/*
+ * CPathfinderTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include <boost/test/unit_test.hpp>
+
+#include "../lib/CGameState.h"
+#include "../lib/StartInfo.h"
+#include "../lib/mapping/CMap.h"
+#include "../lib/mapObjects/CGHeroInstance.h"
+#include "../lib/rmg/CMapGenOptions.h"
+#include "../lib/CStopWatch.h"
+#include "CVcmiTestConfig.h"
+
+namespace
+{
+	// Compares priority order search with FIFO search on whole map and with single destination search on a sample of reachable tiles
+	void checkPathfinder(CGameState & gs, const CGHeroInstance * hero)
+	{
+		CPathsInfo fifo(gs.getMapSize()), priority(gs.getMapSize()), single(gs.getMapSize());
+		CPathfinder(fifo, &gs, hero, CPathfinder::FIFO).calculatePaths();
+		CPathfinder(priority, &gs, hero, CPathfinder::PRIORITY).calculatePaths();
+
+		auto compare = [&](const CGPathNode & expected, const CGPathNode & got, const char * what)
+		{
+			const bool same = expected.reachable() == got.reachable()
+				&& (!expected.reachable() || (expected.turns == got.turns && expected.moveRemains == got.moveRemains));
+			BOOST_CHECK_MESSAGE(same, boost::format("%s search for hero %s at %s: expected %d turns and %d MP, got %d turns and %d MP")
+				% what % hero->name % expected.coord % (int)expected.turns % expected.moveRemains % (int)got.turns % got.moveRemains);
+		};
+
+		std::vector<int3> reachable;
+		for(size_t i = 0; i < fifo.nodes.size(); i++)
+		{
+			compare(fifo.nodes[i], priority.nodes[i], "Priority");
+			if(fifo.nodes[i].reachable())
+				reachable.push_back(fifo.nodes[i].coord);
+		}
+
+		//goal-directed search for every tile would take ages, check evenly spread sample instead
+		const size_t step = std::max<size_t>(1, reachable.size() / 64);
+		for(size_t i = 0; i < reachable.size(); i += step)
+		{
+			CPathfinder(single, &gs, hero).calculatePaths(reachable[i]);
+			compare(fifo.getNode(reachable[i]), single.getNode(reachable[i]), "Single destination");
+		}
+	}
+
+	// Allocation and x-major reset of separate node arrays, as CPathsInfo and initializeGraph did them before single node buffer
+	si64 separateArraysPass(const int3 & sizes)
+	{
+		CGPathNode *** nodes = new CGPathNode**[sizes.x];
+		for(int i = 0; i < sizes.x; i++)
+		{
+			nodes[i] = new CGPathNode*[sizes.y];
+			for(int j = 0; j < sizes.y; j++)
+				nodes[i][j] = new CGPathNode[sizes.z];
+		}
+
+		si64 sum = 0;
+		for(int i = 0; i < sizes.x; i++)
+		{
+			for(int j = 0; j < sizes.y; j++)
+			{
+				for(int k = 0; k < sizes.z; k++)
+				{
+					CGPathNode & node = nodes[i][j][k];
+					node.turns = 0xff;
+					node.moveRemains = 0;
+					node.coord = int3(i, j, k);
+					node.theNodeBefore = nullptr;
+					sum += node.coord.x + node.coord.y + node.coord.z;
+				}
+			}
+		}
+
+		for(int i = 0; i < sizes.x; i++)
+		{
+			for(int j = 0; j < sizes.y; j++)
+				delete [] nodes[i][j];
+			delete [] nodes[i];
+		}
+		delete [] nodes;
+		return sum;
+	}
+
+	StartInfo makeRandomMapStart(ui32 seed, int size)
+	{
+		auto options = std::make_shared<CMapGenOptions>();
+		options->setWidth(size);
+		options->setHeight(size);
+		options->setHasTwoLevels(true);
+		options->setPlayerCount(4);
+
+		StartInfo si;
+		si.mode = StartInfo::NEW_GAME;
+		si.seedToBeUsed = seed;
+		si.mapGenOptions = options;
+		return si;
+	}
+}
+
+// Priority order search and single destination queries must give the same (turns, movement left) as the old FIFO relaxation.
+// Bundled TerrainViewTest map has no heroes nor main towns, so a random map with starting heroes is generated instead.
+BOOST_AUTO_TEST_CASE(CPathfinder_PriorityMatchesFifo)
+{
+	for(ui32 seed : {1, 2, 3})
+	{
+		StartInfo si = makeRandomMapStart(seed, CMapHeader::MAP_SIZE_SMALL);
+		CGameState gs;
+		gs.init(&si);
+		BOOST_REQUIRE(!gs.map->heroesOnMap.empty());
+
+		for(const CGHeroInstance *hero : gs.map->heroesOnMap)
+			checkPathfinder(gs, hero);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(Benchmark)
+
+// Whole map searches for every starting hero of generated XL map with underground.
+// Old per-tile node arrays can't run the search any more, so only their allocation and reset are timed for comparison.
+BOOST_AUTO_TEST_CASE(CPathfinder_XLMapBenchmark)
+{
+	if(!CVcmiTestConfig::benchmarksEnabled())
+		return;
+
+	StartInfo si = makeRandomMapStart(1, CMapHeader::MAP_SIZE_XLARGE);
+	CGameState gs;
+	gs.init(&si);
+	BOOST_REQUIRE(!gs.map->heroesOnMap.empty());
+
+	const int REPEATS = 5;
+	const int3 sizes = gs.getMapSize();
+	const int searches = REPEATS * gs.map->heroesOnMap.size();
+	CStopWatch timer;
+
+	CPathsInfo reused(sizes);
+	si64 reusedSum = 0;
+	for(int i = 0; i < REPEATS; i++)
+	{
+		for(const CGHeroInstance * hero : gs.map->heroesOnMap)
+		{
+			CPathfinder(reused, &gs, hero).calculatePaths();
+			reusedSum += reused.getNode(hero->getPosition(false)).turns;
+		}
+	}
+	const si64 reusedTime = timer.getDiff();
+
+	si64 freshSum = 0;
+	for(int i = 0; i < REPEATS; i++)
+	{
+		for(const CGHeroInstance * hero : gs.map->heroesOnMap)
+		{
+			CPathsInfo fresh(sizes);
+			CPathfinder(fresh, &gs, hero).calculatePaths();
+			freshSum += fresh.getNode(hero->getPosition(false)).turns;
+		}
+	}
+	const si64 freshTime = timer.getDiff();
+
+	si64 separateSum = 0;
+	for(int i = 0; i < searches; i++)
+		separateSum += separateArraysPass(sizes);
+	const si64 separateTime = timer.getDiff();
+
+	BOOST_CHECK_EQUAL(reusedSum, freshSum);
+	BOOST_CHECK(separateSum > 0);
+	logGlobal->infoStream() << boost::format("%d searches on %dx%dx%d map: %d ms with reused node buffer, %d ms with new buffer for each search; "
+		"allocating and resetting separate node arrays alone takes %d ms")
+		% searches % sizes.x % sizes.y % sizes.z % reusedTime % freshTime % separateTime;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,148 @@
+/*
+ * CSaveFileTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include <boost/test/unit_test.hpp>
+
+#include "../lib/Connection.h"
+#include "../lib/registerTypes/RegisterTypes.h"
+#include "../lib/CGameState.h"
+#include "../lib/StartInfo.h"
+#include "../lib/mapping/CMap.h"
+#include "../lib/rmg/CMapGenOptions.h"
+#include "../lib/VCMIDirs.h"
+#include "../lib/CStopWatch.h"
+#include "CVcmiTestConfig.h"
+
+namespace
+{
+	// Writes file without compression, as CSaveFile did before
+	class RawSaveFile : public IBinaryWriter
+	{
+		std::ofstream file;
+	public:
+		COSer serializer;
+
+		RawSaveFile(const boost::filesystem::path & fname)
+			: file(fname.string().c_str(), std::ios::binary), serializer(this)
+		{
+			registerTypes(serializer);
+			file.write(FILE_MAGIC.c_str(), FILE_MAGIC.size());
+			serializer << version;
+		}
+
+		int write(const void * data, unsigned size) override
+		{
+			file.write((const char *)data, size);
+			return size;
+		}
+	};
+
+	boost::filesystem::path testFile(const std::string & name)
+	{
+		return VCMIDirs::get().userCachePath() / ("VCMI_Test_" + name + ".vsgm1");
+	}
+}
+
+BOOST_AUTO_TEST_CASE(CSaveFile_CompressedAndRawFilesLoad)
+{
+	std::vector<si32> numbers(100000);
+	for(size_t i = 0; i < numbers.size(); i++)
+		numbers[i] = i % 1000;
+	const std::string text = "Compressed save test";
+
+	const auto compressed = testFile("compressed"), raw = testFile("raw");
+	{
+		CSaveFile save(compressed.string());
+		save << numbers << text;
+	}
+	{
+		RawSaveFile save(raw);
+		save.serializer << numbers << text;
+	}
+	BOOST_CHECK_LT(boost::filesystem::file_size(compressed), boost::filesystem::file_size(raw));
+
+	for(auto & path : {compressed, raw})
+	{
+		std::vector<si32> loadedNumbers;
+		std::string loadedText;
+		{
+			CLoadFile load(path);
+			load >> loadedNumbers >> loadedText;
+		}
+		BOOST_CHECK(loadedNumbers == numbers);
+		BOOST_CHECK_EQUAL(loadedText, text);
+		boost::filesystem::remove(path);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(Benchmark)
+
+// Game state of generated large map, saved and loaded with and without compression
+BOOST_AUTO_TEST_CASE(CSaveFile_CompressionBenchmark)
+{
+	if(!CVcmiTestConfig::benchmarksEnabled())
+		return;
+
+	auto options = std::make_shared<CMapGenOptions>();
+	options->setWidth(CMapHeader::MAP_SIZE_LARGE);
+	options->setHeight(CMapHeader::MAP_SIZE_LARGE);
+	options->setHasTwoLevels(true);
+	options->setPlayerCount(8);
+
+	StartInfo si;
+	si.mode = StartInfo::NEW_GAME;
+	si.seedToBeUsed = 1;
+	si.mapGenOptions = options;
+
+	CGameState gs;
+	gs.init(&si);
+	CGameState * state = &gs;
+
+	const auto compressed = testFile("benchmark_compressed"), raw = testFile("benchmark_raw");
+	CStopWatch timer;
+	{
+		CSaveFile save(compressed.string());
+		save << state;
+	}
+	const si64 compressedSaveTime = timer.getDiff();
+	{
+		RawSaveFile save(raw);
+		save.serializer << state;
+	}
+	const si64 rawSaveTime = timer.getDiff();
+
+	si64 loadTimes[2];
+	int objects[2];
+	for(int i = 0; i < 2; i++)
+	{
+		CGameState * loaded = nullptr;
+		timer.getDiff();
+		{
+			CLoadFile load(i ? raw : compressed);
+			load >> loaded;
+		}
+		loadTimes[i] = timer.getDiff();
+		objects[i] = loaded->map->objects.size();
+		delete loaded;
+	}
+	BOOST_CHECK_EQUAL(objects[0], gs.map->objects.size());
+	BOOST_CHECK_EQUAL(objects[1], gs.map->objects.size());
+
+	logGlobal->infoStream() << boost::format("Game state with %d objects: compressed %d KB saved in %d ms and loaded in %d ms, "
+		"raw %d KB saved in %d ms and loaded in %d ms")
+		% gs.map->objects.size() % (boost::filesystem::file_size(compressed) / 1024) % compressedSaveTime % loadTimes[0]
+		% (boost::filesystem::file_size(raw) / 1024) % rawSaveTime % loadTimes[1];
+
+	boost::filesystem::remove(compressed);
+	boost::filesystem::remove(raw);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,84 @@
+/*
+ * CTypeListTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include <boost/test/unit_test.hpp>
+
+#include "../lib/Connection.h"
+#include "../lib/mapObjects/MapObjects.h"
+#include "../lib/CStopWatch.h"
+#include "CVcmiTestConfig.h"
+
+namespace
+{
+	// Casts done for every map object in savegame, from pointer type stored in map to most derived type and back
+	std::vector<std::pair<const std::type_info *, const std::type_info *> > objectCasts()
+	{
+		const std::type_info * derived[] = {&typeid(CGHeroInstance), &typeid(CGTownInstance), &typeid(CGCreature), &typeid(CGMine),
+			&typeid(CGDwelling), &typeid(CGResource), &typeid(CGArtifact), &typeid(CGSeerHut), &typeid(CGBorderGate), &typeid(CGMagicSpring)};
+
+		std::vector<std::pair<const std::type_info *, const std::type_info *> > ret;
+		for(auto type : derived)
+		{
+			ret.push_back(std::make_pair(&typeid(CGObjectInstance), type));
+			ret.push_back(std::make_pair(type, &typeid(CGObjectInstance)));
+		}
+		return ret;
+	}
+}
+
+BOOST_AUTO_TEST_CASE(CTypeList_CasterChainMatchesCastSequence)
+{
+	CTypeList types;
+	for(auto & cast : objectCasts())
+	{
+		const size_t steps = types.castSequence(cast.first, cast.second).size() - 1;
+		BOOST_CHECK_EQUAL(types.getCasterChain(cast.first, cast.second).size(), steps);
+		BOOST_CHECK(&types.getCasterChain(cast.first, cast.second) == &types.getCasterChain(cast.first, cast.second)); //found only once
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(Benchmark)
+
+// Before caster chains were remembered, every polymorphic pointer went through castSequence and then a casters map lookup per step,
+// so castSequence alone is lower bound of old cost.
+BOOST_AUTO_TEST_CASE(CTypeList_CasterChainBenchmark)
+{
+	if(!CVcmiTestConfig::benchmarksEnabled())
+		return;
+
+	CTypeList types;
+	const auto casts = objectCasts();
+	const int REPEATS = 20000;
+	si64 chainSum = 0, sequenceSum = 0, idSum = 0;
+	CStopWatch timer;
+
+	for(int i = 0; i < REPEATS; i++)
+		for(auto & cast : casts)
+			chainSum += types.getCasterChain(cast.first, cast.second).size();
+	const si64 chainTime = timer.getDiff();
+
+	for(int i = 0; i < REPEATS; i++)
+		for(auto & cast : casts)
+			sequenceSum += types.castSequence(cast.first, cast.second).size() - 1;
+	const si64 sequenceTime = timer.getDiff();
+
+	for(int i = 0; i < REPEATS; i++)
+		for(auto & cast : casts)
+			idSum += types.getTypeID(cast.second);
+	const si64 idTime = timer.getDiff();
+
+	BOOST_CHECK_EQUAL(chainSum, sequenceSum);
+	BOOST_CHECK(idSum > 0);
+	logGlobal->infoStream() << boost::format("%d casts: remembered caster chain %d ms, castSequence %d ms; %d type ID lookups %d ms")
+		% (REPEATS * casts.size()) % chainTime % sequenceTime % (REPEATS * casts.size()) % idTime;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -35,3 +35,8 @@ CVcmiTestConfig::~CVcmiTestConfig()
 {
 	std::cout << "Ending global test tear-down." << std::endl;
 }
+
+bool CVcmiTestConfig::benchmarksEnabled()
+{
+	return std::getenv("VCMI_BENCHMARK") != nullptr;
+}
@@ -16,4 +16,8 @@ class CVcmiTestConfig
 public:
 	CVcmiTestConfig();
 	~CVcmiTestConfig();
+
+	/// Timing-only cases of Benchmark suite do nothing unless VCMI_BENCHMARK environment variable is set:
+	/// VCMI_BENCHMARK=1 vcmitest --run_test=Benchmark
+	static bool benchmarksEnabled();
 };